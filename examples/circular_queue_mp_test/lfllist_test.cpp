@@ -0,0 +1,139 @@
+// lfllist_test.cpp : This file contains the 'main' function. Program execution begins and ends there.
+//
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdlib>
+#include <algorithm>
+#include "circular_queue/lfllist.h"
+
+constexpr int TOTALMESSAGESTARGET = 4000000;
+// split the threads evenly between producers, that erase some of their items again, and consumers
+const auto THREADS = std::max(std::thread::hardware_concurrency() / 2, 2u);
+const int MESSAGES = TOTALMESSAGESTARGET / THREADS;
+// the items of a producer that are in the list at once, of which every other one is erased,
+// oldest first, such that the erasing competes with the popping of the same nodes
+constexpr int BATCH = 16;
+
+using list_type = ghostl::lfllist<int, std::allocator<ghostl::detail::lfllist_node_type<int>>, void,
+	ghostl::lfllist_deferred_reclaim>;
+
+// runs the producers, which erase, against the consumers, which pop, and a reclaimer,
+// returns the count of items that were lost, or popped more than once
+size_t run(list_type& list)
+{
+	std::vector<std::thread> producers;
+	std::vector<std::thread> consumers;
+	std::atomic<bool> produced(false);
+	std::atomic<size_t> mismatches(0);
+	// per item, the times it was popped, and whether its producer erased it
+	std::unique_ptr<std::atomic<unsigned char>[]> popped(new std::atomic<unsigned char>[THREADS * MESSAGES]());
+	std::vector<bool> erased(THREADS * MESSAGES);
+	for (unsigned i = 0; i < THREADS; ++i)
+	{
+		producers.emplace_back([i, &list, &erased]() {
+			list_type::node_type* nodes[BATCH];
+			for (int c = 0; c < MESSAGES; c += BATCH)
+			{
+				// keeps the nodes valid until they are erased, even if a consumer has popped them
+				list_type::read_guard guard(list);
+				const int n = std::min(BATCH, MESSAGES - c);
+				for (int j = 0; j < n; ++j)
+				{
+					nodes[j] = list.emplace_front(static_cast<int>(i * MESSAGES + c + j));
+				}
+				for (int j = 0; j < n; j += 2)
+				{
+					erased[i * MESSAGES + c + j] = true;
+					list.erase(nodes[j]);
+				}
+			}
+			});
+	}
+	for (unsigned i = 0; i < THREADS; ++i)
+	{
+		consumers.emplace_back([&list, &produced, &mismatches, &popped]() {
+			for (;;)
+			{
+				// once all producers have completed, an empty list stays empty
+				const bool done = produced.load();
+				int item;
+				if (list.try_pop(item))
+				{
+					if (item < 0 || item >= static_cast<int>(THREADS) * MESSAGES) ++mismatches;
+					else ++popped[item];
+				}
+				else if (done && !list.back())
+				{
+					break;
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+			});
+	}
+	std::thread reclaimer([&list, &produced]() {
+		while (!produced.load())
+		{
+			list.reclaim();
+			std::this_thread::yield();
+		}
+		});
+	for (auto& thread : producers) thread.join();
+	produced.store(true);
+	for (auto& thread : consumers) thread.join();
+	reclaimer.join();
+	list.reclaim();
+	// every item that was not erased must have been popped exactly once, erased ones at most once
+	size_t lost = 0;
+	size_t duplicates = 0;
+	for (size_t k = 0; k < THREADS * MESSAGES; ++k)
+	{
+		const unsigned count = popped[k].load();
+		if (!count && !erased[k]) ++lost;
+		if (count > 1) duplicates += count - 1;
+	}
+	if (mismatches) std::cerr << mismatches << " item mismatches" << std::endl;
+	if (lost) std::cerr << lost << " items lost" << std::endl;
+	if (duplicates) std::cerr << duplicates << " items duplicated" << std::endl;
+	return mismatches + lost + duplicates;
+}
+
+int main()
+{
+	using namespace std::chrono_literals;
+	std::cerr << "Utilizing " << THREADS << " producer and " << THREADS << " consumer threads" << std::endl;
+	std::atomic<bool> finished(false);
+	// a node unlinked twice can make the erasing or popping threads spin forever
+	std::thread watchdog([&finished]() {
+		const auto deadline = std::chrono::steady_clock::now() + 120s;
+		while (!finished.load())
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+			{
+				std::cerr << "lfllist deferred reclaim: hung" << std::endl;
+				std::_Exit(1);
+			}
+			std::this_thread::sleep_for(10ms);
+		}
+		});
+	bool passed;
+	{
+		list_type list;
+		const auto begin = std::chrono::steady_clock::now();
+		passed = !run(list);
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		std::cerr << "lfllist deferred reclaim: " << elapsed.count() << "s, "
+			<< THREADS * MESSAGES / elapsed.count() << " items/s" << std::endl;
+	}
+	finished.store(true);
+	watchdog.join();
+	std::cerr << (passed ? "passed" : "FAILED") << std::endl;
+	return passed ? 0 : 1;
+}
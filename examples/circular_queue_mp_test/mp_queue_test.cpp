@@ -5,6 +5,7 @@
 #include <thread>
 #include <chrono>
 #include <vector>
+#include <algorithm>
 #include "circular_queue/circular_queue_mp.h"
 
 struct qitem
@@ -17,19 +18,20 @@ struct qitem
 
 constexpr int TOTALMESSAGESTARGET = 60000000;
 // reserve one thread as consumer
-const auto THREADS = std::thread::hardware_concurrency() / 2 - 1;
+const auto THREADS = std::max(std::thread::hardware_concurrency() / 2, 2u) - 1;
 const int MESSAGES = TOTALMESSAGESTARGET / THREADS;
-circular_queue<std::thread> threads(THREADS);
-circular_queue_mp<qitem> queue(threads.capacity()* MESSAGES / 10);
-std::vector<int> checks(threads.capacity());
 
-int main()
+// runs all producers against one consumer, returns the elapsed time
+template<typename Queue>
+std::chrono::duration<double> run(Queue& queue)
 {
 	using namespace std::chrono_literals;
-	std::cerr << "Utilizing " << THREADS << " producer threads" << std::endl;
+	circular_queue<std::thread> threads(THREADS);
+	std::vector<int> checks(threads.capacity());
+	const auto begin = std::chrono::steady_clock::now();
 	for (int i = 0; i < threads.capacity(); ++i)
 	{
-		threads.push(std::thread([i]() {
+		threads.push(std::thread([i, &queue]() {
 			for (int c = 0; c < MESSAGES;)
 			{
 				// simulate some load
@@ -42,7 +44,7 @@ int main()
 				else
 				{
 					//std::cerr << "queue full" << std::endl;
-					//std::this_thread::sleep_for(10us);
+					std::this_thread::yield();
 				}
 				//if (0 == c % 10000) std::this_thread::sleep_for(10us);
 			}
@@ -55,7 +57,7 @@ int main()
 		{
 			auto starvedFor = std::chrono::system_clock::now() - now;
 			if (starvedFor > 20s) std::cerr << "queue starved for > 20s" << std::endl;
-			//std::this_thread::sleep_for(20ms);
+			std::this_thread::yield();
 		}
 		auto item = queue.pop();
 		if (checks[item.id] != item.val)
@@ -70,5 +72,27 @@ int main()
 		auto thread = threads.pop();
 		thread.join();
 	}
+	return std::chrono::steady_clock::now() - begin;
+}
+
+template<typename Queue>
+void report(const char* name, Queue& queue)
+{
+	const auto elapsed = run(queue);
+	std::cerr << name << ": " << elapsed.count() << "s, "
+		<< THREADS * MESSAGES / elapsed.count() << " items/s" << std::endl;
+}
+
+int main()
+{
+	std::cerr << "Utilizing " << THREADS << " producer threads" << std::endl;
+	{
+		circular_queue_mp<qitem> queue(THREADS * MESSAGES / 10);
+		report("counted", queue);
+	}
+	{
+		circular_queue_mp<qitem, void, mp_policy_sequenced> queue(THREADS * MESSAGES / 10);
+		report("sequenced", queue);
+	}
 	return 0;
 }
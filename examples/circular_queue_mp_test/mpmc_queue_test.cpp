@@ -0,0 +1,148 @@
+// mpmc_queue_test.cpp : This file contains the 'main' function. Program execution begins and ends there.
+//
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include "circular_queue/circular_queue_mpmc.h"
+
+struct qitem
+{
+	// producer id
+	int id;
+	// monotonic increasing value
+	int val = 0;
+};
+
+constexpr int TOTALMESSAGESTARGET = 60000000;
+// split the threads evenly between producers and consumers
+const auto THREADS = std::max(std::thread::hardware_concurrency() / 2, 1u);
+const int MESSAGES = TOTALMESSAGESTARGET / THREADS;
+
+// consumers serialized by a mutex around the multi-producer, single-consumer queue
+struct locked_queue
+{
+	locked_queue(size_t capacity) : queue(capacity) {}
+	bool push(qitem&& item) { return queue.push(std::move(item)); }
+	size_t pop_n(qitem* buffer, size_t size)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return queue.pop_n(buffer, size);
+	}
+	circular_queue_mp<qitem> queue;
+	std::mutex mutex;
+};
+
+// runs all producers against all consumers, returns the elapsed time,
+// and in failures the count of items that were lost, duplicated or out of order
+template<typename Queue>
+std::chrono::duration<double> run(Queue& queue, size_t& failures)
+{
+	using namespace std::chrono_literals;
+	std::vector<std::thread> producers;
+	std::vector<std::thread> consumers;
+	std::atomic<bool> produced(false);
+	std::atomic<size_t> mismatches(0);
+	// per consumer, the items it received, by id * MESSAGES + val
+	std::vector<std::vector<bool>> received(THREADS, std::vector<bool>(THREADS * MESSAGES));
+	const auto begin = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < THREADS; ++i)
+	{
+		producers.emplace_back([i, &queue]() {
+			for (int c = 0; c < MESSAGES;)
+			{
+				// simulate some load
+				auto start = std::chrono::system_clock::now();
+				while (std::chrono::system_clock::now() - start < 1us);
+				if (queue.push({ static_cast<int>(i), c }))
+				{
+					++c;
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+			});
+	}
+	for (unsigned i = 0; i < THREADS; ++i)
+	{
+		consumers.emplace_back([&queue, &produced, &mismatches, &seen = received[i]]() {
+			// values of each producer must increase, even if other consumers take some in between
+			std::vector<int> last(THREADS, -1);
+			qitem items[4];
+			for (;;)
+			{
+				// once all pushes have completed, an empty queue stays empty
+				const bool done = produced.load();
+				const auto n = queue.pop_n(items, 4);
+				if (!n)
+				{
+					if (done) break;
+					std::this_thread::yield();
+					continue;
+				}
+				for (size_t j = 0; j < n; ++j)
+				{
+					const auto& item = items[j];
+					if (item.id < 0 || item.id >= static_cast<int>(THREADS) || item.val < 0 || item.val >= MESSAGES ||
+						item.val <= last[item.id] || seen[item.id * MESSAGES + item.val])
+					{
+						++mismatches;
+						continue;
+					}
+					last[item.id] = item.val;
+					seen[item.id * MESSAGES + item.val] = true;
+				}
+			}
+			});
+	}
+	for (auto& thread : producers) thread.join();
+	produced.store(true);
+	for (auto& thread : consumers) thread.join();
+	const auto elapsed = std::chrono::steady_clock::now() - begin;
+	// every value of every producer must have been received by exactly one consumer
+	size_t lost = 0;
+	size_t duplicates = 0;
+	for (size_t k = 0; k < THREADS * MESSAGES; ++k)
+	{
+		unsigned count = 0;
+		for (const auto& seen : received) count += seen[k];
+		if (!count) ++lost;
+		else duplicates += count - 1;
+	}
+	if (mismatches) std::cerr << mismatches << " item mismatches" << std::endl;
+	if (lost) std::cerr << lost << " items lost" << std::endl;
+	if (duplicates) std::cerr << duplicates << " items duplicated" << std::endl;
+	failures = mismatches + lost + duplicates;
+	return elapsed;
+}
+
+template<typename Queue>
+bool report(const char* name, Queue& queue)
+{
+	size_t failures;
+	const auto elapsed = run(queue, failures);
+	std::cerr << name << ": " << elapsed.count() << "s, "
+		<< THREADS * MESSAGES / elapsed.count() << " items/s" << std::endl;
+	return !failures;
+}
+
+int main()
+{
+	std::cerr << "Utilizing " << THREADS << " producer and " << THREADS << " consumer threads" << std::endl;
+	bool passed = true;
+	{
+		locked_queue queue(THREADS * MESSAGES / 10);
+		passed = report("circular_queue_mp with mutex", queue) && passed;
+	}
+	{
+		circular_queue_mpmc<qitem> queue(THREADS * MESSAGES / 10);
+		passed = report("circular_queue_mpmc", queue) && passed;
+	}
+	return passed ? 0 : 1;
+}
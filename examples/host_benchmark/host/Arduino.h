@@ -0,0 +1,104 @@
+#pragma once
+/*
+Arduino.h - Minimal host (non-ARDUINO) stand-in for the Arduino core,
+            just enough to build EspSoftwareSerial for benchmarking its decoder.
+Copyright (c) 2023 Dirk O. Kaar. All rights reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x00
+#define INPUT_PULLUP 0x02
+#define OUTPUT 0x01
+#define OUTPUT_OPEN_DRAIN 0x03
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define F_CPU 80000000L
+
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+
+using std::min;
+using std::max;
+
+inline unsigned long micros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+inline unsigned long millis() { return micros() / 1000UL; }
+inline void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void delayMicroseconds(unsigned int us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+inline void yield() { std::this_thread::yield(); }
+inline void optimistic_yield(uint32_t) {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline uint32_t xt_rsil(int) { return 0; }
+inline void xt_wsr_ps(uint32_t) {}
+
+// the host has no GPIOs, the pins read and write to a shadow register
+inline volatile uint32_t hostGPIO = ~0U;
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t val) {
+    if (val) hostGPIO |= 1UL << pin;
+    else hostGPIO &= ~(1UL << pin);
+}
+inline int digitalRead(uint8_t pin) { return (hostGPIO >> pin) & 1; }
+inline void attachInterruptArg(uint8_t, void (*)(void*), void*, int) {}
+inline void detachInterrupt(uint8_t) {}
+#define digitalPinToInterrupt(pin) (pin)
+#define digitalPinToPort(pin) ((void)(pin), 0)
+#define digitalPinToBitMask(pin) (1UL << (pin))
+#define portInputRegister(port) ((void)(port), &hostGPIO)
+#define portOutputRegister(port) ((void)(port), &hostGPIO)
+
+struct EspClass {
+    uint32_t getCycleCount() { return micros() * getCpuFreqMHz(); }
+    uint8_t getCpuFreqMHz() { return F_CPU / 1000000L; }
+};
+inline EspClass ESP;
+
+// alarms never fire, which leaves async tx and timer rx inoperative
+typedef struct esp_timer* esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void* arg);
+typedef enum { ESP_TIMER_TASK, ESP_TIMER_ISR } esp_timer_dispatch_t;
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t*, esp_timer_handle_t*) { return ESP_FAIL; }
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t, uint64_t) { return ESP_FAIL; }
+inline esp_err_t esp_timer_stop(esp_timer_handle_t) { return ESP_FAIL; }
+inline esp_err_t esp_timer_delete(esp_timer_handle_t) { return ESP_FAIL; }
+
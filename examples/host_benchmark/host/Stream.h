@@ -0,0 +1,55 @@
+#pragma once
+/*
+Stream.h - Minimal host (non-ARDUINO) stand-in for the Arduino Stream class.
+Copyright (c) 2023 Dirk O. Kaar. All rights reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char* str) {
+        return str ? write(reinterpret_cast<const uint8_t*>(str), strlen(str)) : 0;
+    }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual size_t readBytes(uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        for (int c; n < size && (c = read()) >= 0; ++n) buffer[n] = c;
+        return n;
+    }
+    virtual size_t readBytes(char* buffer, size_t size) {
+        return readBytes(reinterpret_cast<uint8_t*>(buffer), size);
+    }
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+protected:
+    unsigned long _timeout = 1000;
+};
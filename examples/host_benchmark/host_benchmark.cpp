@@ -0,0 +1,334 @@
+// host_benchmark.cpp : Host (non-ARDUINO) benchmarks of the rx decoder, queues and delegates.
+//
+// Build and run from the library root, e.g.:
+// g++ -std=c++17 -O2 -Iexamples/host_benchmark/host -Isrc examples/host_benchmark/host_benchmark.cpp src/SoftwareSerial.cpp -pthread -o host_benchmark && ./host_benchmark
+// Add -DSWSERIAL_SIM for the loopback through the simulated GPIOs, which then also time the decoder.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include "SoftwareSerial.h"
+#include "circular_queue/circular_queue_mp.h"
+#include "circular_queue/circular_queue_mpmc.h"
+#include "circular_queue/Delegate.h"
+#include "circular_queue/MultiDelegate.h"
+
+using clk = std::chrono::steady_clock;
+
+// defeats the optimizer for benchmarked results
+volatile uint32_t sink;
+
+void report(const char* name, const char* unit, size_t ops, clk::duration elapsed)
+{
+	const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+	std::cout << std::left << std::setw(48) << name << std::right << std::setw(10)
+		<< std::fixed << std::setprecision(2) << ns / ops << " ns/" << unit << std::endl;
+}
+
+// exposes the edge capture of the rx ISR, as the entry to the decoder
+struct ReplayUART : EspSoftwareSerial::UART
+{
+	using EspSoftwareSerial::UART::pushRxEdge;
+};
+
+struct Edge
+{
+	uint32_t tick;
+	bool level;
+	// the leading edge of a start bit
+	bool frame;
+};
+
+// the rx edges of the frames of data at baud, with 1/8 bit stop time jitter between frames
+std::vector<Edge> edges(uint32_t baud, EspSoftwareSerial::Config config, const std::vector<uint8_t>& data)
+{
+	const unsigned dataBits = 5 + (config & 07);
+	const auto parity = static_cast<EspSoftwareSerial::Parity>(config & 070);
+	const unsigned stopBits = 1 + ((config & 0300) ? 1 : 0);
+	const double bitTicks = 2000000.0 / baud;
+	std::vector<Edge> result;
+	double tick = 0;
+	bool level = true;
+	bool frame = false;
+	auto bit = [&](bool b) {
+		if (b != level) result.push_back({ static_cast<uint32_t>(tick), level = b, frame });
+		frame = false;
+		tick += bitTicks;
+	};
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		const uint8_t byte = data[i] & ((1 << dataBits) - 1);
+		frame = true;
+		bit(false);
+		for (unsigned b = 0; b < dataBits; ++b) bit((byte >> b) & 1);
+		switch (parity)
+		{
+		case EspSoftwareSerial::PARITY_EVEN: bit(EspSoftwareSerial::UART::parityEven(byte)); break;
+		case EspSoftwareSerial::PARITY_ODD: bit(EspSoftwareSerial::UART::parityOdd(byte)); break;
+		case EspSoftwareSerial::PARITY_MARK: bit(true); break;
+		case EspSoftwareSerial::PARITY_SPACE: bit(false); break;
+		default: break;
+		}
+		for (unsigned b = 0; b < stopBits; ++b) bit(true);
+		tick += (i % 8) * bitTicks / 8;
+	}
+	return result;
+}
+
+void benchDecoder(const char* name, uint32_t baud, EspSoftwareSerial::Config config)
+{
+	constexpr size_t BYTES = 1 << 20;
+	constexpr int ISRCAPACITY = 1024;
+	std::vector<uint8_t> data(BYTES);
+	for (size_t i = 0; i < BYTES; ++i) data[i] = static_cast<uint8_t>(i * 73 + 41);
+	const auto stream = edges(baud, config, data);
+
+	ReplayUART uart;
+	uart.begin(baud, config, 4, -1, false, 256, ISRCAPACITY);
+	const uint32_t base = (micros() << 1) + 1000;
+	size_t received = 0;
+	size_t mismatches = 0;
+	const auto start = clk::now();
+	for (size_t i = 0; i < stream.size();)
+	{
+		// replay a burst of whole frames, then decode it by available(), which completes the last frame
+		size_t end = std::min(i + ISRCAPACITY / 2, stream.size());
+		while (end < stream.size() && !stream[end].frame) --end;
+		for (; i < end; ++i) uart.pushRxEdge(base + stream[i].tick, stream[i].level);
+		while (uart.available())
+		{
+			const int c = uart.read();
+			if (received < BYTES && c != (data[received] & ((1 << (5 + (config & 07))) - 1))) ++mismatches;
+			++received;
+		}
+	}
+	report(name, "edge", stream.size(), clk::now() - start);
+	if (received != BYTES || mismatches) std::cerr << name << ": " << received << " bytes, " << mismatches << " mismatches" << std::endl;
+}
+
+#ifdef SWSERIAL_SIM
+// the tx of one UART wired to the rx of another, whose real rx edge ISR runs in the writer's context
+void benchLoopback(const char* name, uint32_t baud, EspSoftwareSerial::Config config)
+{
+	using EspSoftwareSerial::SimHal;
+	constexpr size_t BYTES = 4096;
+	constexpr size_t CHUNK = 64;
+	const uint8_t mask = (1 << (5 + (config & 07))) - 1;
+	std::vector<uint8_t> data(BYTES);
+	for (size_t i = 0; i < BYTES; ++i) data[i] = static_cast<uint8_t>(i * 73 + 41);
+
+	SimHal::reset();
+	SimHal::connect(5, 4);
+	EspSoftwareSerial::UART tx;
+	EspSoftwareSerial::UART rx;
+	tx.begin(baud, config, -1, 5);
+	rx.begin(baud, config, 4, -1, false, 2 * CHUNK);
+	size_t received = 0;
+	size_t mismatches = 0;
+	auto drain = [&]() {
+		while (rx.available())
+		{
+			const int c = rx.read();
+			if (received < BYTES && c != (data[received] & mask)) ++mismatches;
+			++received;
+		}
+	};
+	const uint64_t simStart = SimHal::nanos();
+	const auto start = clk::now();
+	for (size_t i = 0; i < BYTES; i += CHUNK)
+	{
+		tx.write(&data[i], CHUNK);
+		drain();
+	}
+	const uint64_t simElapsed = SimHal::nanos() - simStart;
+	const auto elapsed = clk::now() - start;
+	// the stop bit of the last frame
+	SimHal::delay(1);
+	drain();
+	report(name, "byte", BYTES, elapsed);
+	const unsigned frameBits = 1 + 5 + (config & 07) + ((config & 070) ? 1 : 0) + ((config & 0300) ? 2 : 1);
+	std::cout << "    effective " << std::fixed << std::setprecision(0)
+		<< BYTES * frameBits * 1e9 / simElapsed << " bps simulated" << std::endl;
+	if (received != BYTES || mismatches) std::cerr << name << ": " << received << " bytes, " << mismatches << " mismatches" << std::endl;
+	tx.end();
+	rx.end();
+}
+
+// broadcast to PORTS wired UARTs, one after the other, and by the UARTMultiWriter
+void benchBroadcast(const char* name, uint32_t baud, EspSoftwareSerial::Config config)
+{
+	using EspSoftwareSerial::SimHal;
+	constexpr int PORTS = 8;
+	constexpr size_t BYTES = 256;
+	const uint8_t mask = (1 << (5 + (config & 07))) - 1;
+	std::vector<uint8_t> data(BYTES);
+	for (size_t i = 0; i < BYTES; ++i) data[i] = static_cast<uint8_t>(i * 73 + 41);
+
+	SimHal::reset();
+	EspSoftwareSerial::UART tx[PORTS];
+	EspSoftwareSerial::UART rx[PORTS];
+	EspSoftwareSerial::UARTMultiWriter writer;
+	for (int p = 0; p < PORTS; ++p)
+	{
+		SimHal::connect(16 + p, p);
+		tx[p].begin(baud, config, -1, 16 + p);
+		rx[p].begin(baud, config, p, -1, false, 2 * BYTES);
+		writer.add(tx[p]);
+	}
+	size_t mismatches = 0;
+	auto drain = [&]() {
+		// the stop bit of the last frame
+		SimHal::delay(1);
+		for (int p = 0; p < PORTS; ++p)
+		{
+			size_t received = 0;
+			while (rx[p].available())
+			{
+				const int c = rx[p].read();
+				if (received >= BYTES || c != (data[received] & mask)) ++mismatches;
+				++received;
+			}
+			if (received != BYTES) ++mismatches;
+		}
+	};
+	uint64_t simStart = SimHal::nanos();
+	for (int p = 0; p < PORTS; ++p) tx[p].write(data.data(), BYTES);
+	const uint64_t sequential = SimHal::nanos() - simStart;
+	drain();
+	simStart = SimHal::nanos();
+	const auto start = clk::now();
+	writer.write(data.data(), BYTES);
+	const auto elapsed = clk::now() - start;
+	const uint64_t parallel = SimHal::nanos() - simStart;
+	drain();
+	report(name, "byte", BYTES, elapsed);
+	std::cout << "    " << PORTS << " ports " << std::fixed << std::setprecision(2)
+		<< sequential / 1e6 << " ms sequential, " << parallel / 1e6 << " ms parallel, simulated" << std::endl;
+	if (mismatches) std::cerr << name << ": " << mismatches << " mismatches" << std::endl;
+	for (int p = 0; p < PORTS; ++p)
+	{
+		tx[p].end();
+		rx[p].end();
+	}
+}
+#endif // SWSERIAL_SIM
+
+template<typename Queue>
+void benchQueue(const char* name, Queue& queue, unsigned producers)
+{
+	constexpr size_t ITEMS = 1 << 22;
+	const size_t perProducer = ITEMS / producers;
+	std::vector<std::thread> threads;
+	const auto start = clk::now();
+	for (unsigned p = 0; p < producers; ++p)
+	{
+		threads.emplace_back([&queue, perProducer]() {
+			for (size_t i = 0; i < perProducer;)
+			{
+				if (queue.push(static_cast<uint32_t>(i))) ++i;
+				else std::this_thread::yield();
+			}
+			});
+	}
+	uint32_t buffer[64];
+	for (size_t popped = 0; popped < perProducer * producers;)
+	{
+		const size_t n = queue.pop_n(buffer, 64);
+		if (!n) std::this_thread::yield();
+		popped += n;
+		if (n) sink = buffer[n - 1];
+	}
+	for (auto& thread : threads) thread.join();
+	report(name, "item", perProducer * producers, clk::now() - start);
+}
+
+template<typename F>
+void benchCall(const char* name, F&& f)
+{
+	constexpr size_t CALLS = 1 << 24;
+	uint32_t sum = 0;
+	const auto start = clk::now();
+	for (size_t i = 0; i < CALLS; ++i) sum += f(static_cast<uint32_t>(i));
+	const auto elapsed = clk::now() - start;
+	sink = sum;
+	report(name, "call", CALLS, elapsed);
+}
+
+void benchMultiDelegate(const char* name, size_t subscribers)
+{
+	constexpr size_t CALLS = 1 << 20;
+	uint32_t sum = 0;
+	MultiDelegate<Delegate<void(uint32_t)>> multi;
+	for (size_t s = 0; s < subscribers; ++s) multi += [&sum](uint32_t v) { sum += v; };
+	const auto start = clk::now();
+	for (size_t i = 0; i < CALLS; ++i) multi(static_cast<uint32_t>(i));
+	const auto elapsed = clk::now() - start;
+	sink = sum;
+	report(name, "dispatch", CALLS, elapsed);
+}
+
+uint32_t plainFunction(uint32_t v)
+{
+	return v ^ sink;
+}
+
+int main()
+{
+	std::cout << "rx decoder" << std::endl;
+	benchDecoder("  9600 8N1", 9600, EspSoftwareSerial::SWSERIAL_8N1);
+	benchDecoder("  115200 8N1", 115200, EspSoftwareSerial::SWSERIAL_8N1);
+	benchDecoder("  57600 8E1", 57600, EspSoftwareSerial::SWSERIAL_8E1);
+	benchDecoder("  19200 7O2", 19200, EspSoftwareSerial::SWSERIAL_7O2);
+	benchDecoder("  4800 5N1", 4800, EspSoftwareSerial::SWSERIAL_5N1);
+#ifdef SWSERIAL_SIM
+	std::cout << "simulated loopback" << std::endl;
+	benchLoopback("  9600 8N1", 9600, EspSoftwareSerial::SWSERIAL_8N1);
+	benchLoopback("  57600 8E1", 57600, EspSoftwareSerial::SWSERIAL_8E1);
+	benchLoopback("  19200 7O2", 19200, EspSoftwareSerial::SWSERIAL_7O2);
+	std::cout << "simulated broadcast" << std::endl;
+	benchBroadcast("  9600 8N1", 9600, EspSoftwareSerial::SWSERIAL_8N1);
+	benchBroadcast("  57600 8E1", 57600, EspSoftwareSerial::SWSERIAL_8E1);
+#endif // SWSERIAL_SIM
+
+	const unsigned hw = std::max(std::thread::hardware_concurrency(), 2u);
+	std::cout << "queues, with one consumer" << std::endl;
+	{
+		circular_queue<uint32_t> queue(4096);
+		benchQueue("  circular_queue, 1 producer", queue, 1);
+	}
+	for (unsigned producers = 1; producers < hw; producers *= 2)
+	{
+		const std::string suffix = ", " + std::to_string(producers) + " producer(s)";
+		{
+			circular_queue_mp<uint32_t> queue(4096);
+			benchQueue(("  circular_queue_mp" + suffix).c_str(), queue, producers);
+		}
+		{
+			circular_queue_mp<uint32_t, void, mp_policy_sequenced> queue(4096);
+			benchQueue(("  circular_queue_mp sequenced" + suffix).c_str(), queue, producers);
+		}
+		{
+			circular_queue_mpmc<uint32_t> queue(4096);
+			benchQueue(("  circular_queue_mpmc" + suffix).c_str(), queue, producers);
+		}
+	}
+
+	std::cout << "delegates" << std::endl;
+	uint32_t captured = 3;
+	benchCall("  Delegate, function pointer", Delegate<uint32_t(uint32_t)>(plainFunction));
+	benchCall("  Delegate, function pointer and arg", Delegate<uint32_t(uint32_t), uint32_t*>(
+		[](uint32_t* c, uint32_t v) { return v + *c; }, &captured));
+	benchCall("  Delegate, capturing lambda", Delegate<uint32_t(uint32_t)>([&captured](uint32_t v) { return v + captured; }));
+	benchCall("  std::function, function pointer", std::function<uint32_t(uint32_t)>(plainFunction));
+	benchCall("  std::function, capturing lambda", std::function<uint32_t(uint32_t)>([&captured](uint32_t v) { return v + captured; }));
+	for (size_t subscribers : { 1, 4, 16 })
+	{
+		benchMultiDelegate(("  MultiDelegate, " + std::to_string(subscribers) + " subscriber(s)").c_str(), subscribers);
+	}
+	return 0;
+}
@@ -28,24 +28,148 @@ uint32_t UARTBase::m_savedPS = 0;
 #else
 portMUX_TYPE UARTBase::m_interruptsMux = portMUX_INITIALIZER_UNLOCKED;
 #endif
+#ifdef CCY_TICKS
+uint32_t UARTBase::m_cpuFreqMHz = F_CPU / 1000000UL;
+#endif
 
-ALWAYS_INLINE_ATTR inline void IRAM_ATTR UARTBase::disableInterrupts()
-{
-#ifndef ESP32
-    m_savedPS = xt_rsil(15);
+#if defined(ESP8266)
+TimerAlarm* TimerAlarm::s_first = nullptr;
+bool TimerAlarm::s_dispatching = false;
+
+namespace {
+    // timer1 is clocked at 80MHz, TIM_DIV16 yields 5 timer ticks per microsecond
+    constexpr uint32_t TIMER1_TICKS_PER_MICRO = 5;
+    constexpr uint32_t TIMER1_MIN_TICKS = 10;
+    constexpr uint32_t TIMER1_MAX_TICKS = 0x7fffff;
+}
+
+TimerAlarm::~TimerAlarm() {
+    end();
+}
+
+bool TimerAlarm::begin(void (*handler)(void*), void* arg) {
+    end();
+    m_handler = handler;
+    m_arg = arg;
+    m_armed = false;
+    const uint32_t savedPS = xt_rsil(15);
+    if (!s_first) {
+        timer1_isr_init();
+        timer1_attachInterrupt(timer1ISR);
+        timer1_enable(TIM_DIV16, TIM_EDGE, TIM_SINGLE);
+    }
+    m_next = s_first;
+    s_first = this;
+    xt_wsr_ps(savedPS);
+    return true;
+}
+
+void TimerAlarm::end() {
+    if (!m_handler) return;
+    const uint32_t savedPS = xt_rsil(15);
+    m_armed = false;
+    for (auto link = &s_first; *link; link = &(*link)->m_next) {
+        if (*link == this) {
+            *link = m_next;
+            break;
+        }
+    }
+    if (!s_first) {
+        timer1_disable();
+        timer1_detachInterrupt();
+    }
+    xt_wsr_ps(savedPS);
+    m_next = nullptr;
+    m_handler = nullptr;
+}
+
+void IRAM_ATTR TimerAlarm::arm(uint32_t delayMicros) {
+    const uint32_t savedPS = xt_rsil(15);
+    m_due = micros() + delayMicros;
+    m_armed = true;
+    // timer1ISR reschedules after all handlers have run
+    if (!s_dispatching) reschedule();
+    xt_wsr_ps(savedPS);
+}
+
+void TimerAlarm::disarm() {
+    // a pending timer1 interrupt finds no due alarm and is harmless
+    m_armed = false;
+}
+
+TimerAlarm::operator bool() const {
+    return m_handler;
+}
+
+void IRAM_ATTR TimerAlarm::reschedule() {
+    const uint32_t now = micros();
+    bool armed = false;
+    uint32_t next = ~0UL;
+    for (auto alarm = s_first; alarm; alarm = alarm->m_next) {
+        if (!alarm->m_armed) continue;
+        const int32_t remaining = alarm->m_due - now;
+        next = min(next, static_cast<uint32_t>(max(remaining, static_cast<int32_t>(0))));
+        armed = true;
+    }
+    if (armed) {
+        timer1_write(min(max(next * TIMER1_TICKS_PER_MICRO, TIMER1_MIN_TICKS), TIMER1_MAX_TICKS));
+    }
+}
+
+void IRAM_ATTR TimerAlarm::timer1ISR() {
+    s_dispatching = true;
+    for (auto alarm = s_first; alarm; alarm = alarm->m_next) {
+        if (alarm->m_armed && static_cast<int32_t>(alarm->m_due - micros()) <= 0) {
+            alarm->m_armed = false;
+            alarm->m_handler(alarm->m_arg);
+        }
+    }
+    s_dispatching = false;
+    reschedule();
+}
 #else
-    taskENTER_CRITICAL(&m_interruptsMux);
-#endif
+TimerAlarm::~TimerAlarm() {
+    end();
 }
 
-ALWAYS_INLINE_ATTR inline void IRAM_ATTR UARTBase::restoreInterrupts()
-{
-#ifndef ESP32
-    xt_wsr_ps(m_savedPS);
+bool TimerAlarm::begin(void (*handler)(void*), void* arg) {
+    end();
+    esp_timer_create_args_t args = {};
+    args.callback = handler;
+    args.arg = arg;
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    args.dispatch_method = ESP_TIMER_ISR;
 #else
-    taskEXIT_CRITICAL(&m_interruptsMux);
+    args.dispatch_method = ESP_TIMER_TASK;
 #endif
+    args.name = "swserial";
+    if (ESP_OK != esp_timer_create(&args, &m_timer)) {
+        m_timer = nullptr;
+    }
+    return m_timer;
+}
+
+void TimerAlarm::end() {
+    if (!m_timer) return;
+    esp_timer_stop(m_timer);
+    esp_timer_delete(m_timer);
+    m_timer = nullptr;
+}
+
+void IRAM_ATTR TimerAlarm::arm(uint32_t delayMicros) {
+    // starting fails for a timer that is still running
+    esp_timer_stop(m_timer);
+    esp_timer_start_once(m_timer, delayMicros);
+}
+
+void TimerAlarm::disarm() {
+    esp_timer_stop(m_timer);
+}
+
+TimerAlarm::operator bool() const {
+    return m_timer;
 }
+#endif
 
 constexpr uint8_t BYTE_ALL_BITS_SET = ~static_cast<uint8_t>(0);
 
@@ -65,13 +189,13 @@ UARTBase::~UARTBase() {
 
 void UARTBase::setRxGPIOPinMode() {
     if (m_rxValid) {
-        pinMode(m_rxPin, m_rxGPIOHasPullUp && m_rxGPIOPullUpEnabled ? INPUT_PULLUP : INPUT);
+        Hal::pinMode(m_rxPin, m_rxGPIOHasPullUp && m_rxGPIOPullUpEnabled ? INPUT_PULLUP : INPUT);
     }
 }
 
 void UARTBase::setTxGPIOPinMode() {
     if (m_txValid) {
-        pinMode(m_txPin, m_txGPIOOpenDrain ? OUTPUT_OPEN_DRAIN : OUTPUT);
+        Hal::pinMode(m_txPin, m_txGPIOOpenDrain ? OUTPUT_OPEN_DRAIN : OUTPUT);
     }
 }
 
@@ -86,22 +210,79 @@ void UARTBase::begin(uint32_t baud, Config config,
     m_parityMode = static_cast<Parity>(config & 070);
     m_stopBits = 1 + ((config & 0300) ? 1 : 0);
     m_pduBits = m_dataBits + static_cast<bool>(m_parityMode) + m_stopBits;
-    m_bitTicks = (microsToTicks(1000000UL) + baud / 2) / baud;
+    syncTimebase();
+    setBitTicksFx(((static_cast<uint64_t>(microsToTicks(1000000UL)) << 8) + baud / 2) / baud);
+    m_autoBaudEdges = 0;
+    m_calTicks = 0;
+    m_calBits = 0;
     m_intTxEnabled = true;
 }
 
+void UARTBase::setBitTicksFx(uint32_t bitTicksFx) {
+    m_bitTicksFx = bitTicksFx;
+    m_bitTicks = (bitTicksFx + 128) >> 8;
+    // ceil(2^40 / m_bitTicksFx), for x < 2^24 the product with x is off the division by less than 1/256
+    m_bitTicksRecip = (bitTicksFx > 256) ? static_cast<uint32_t>(((1ULL << 40) - 1) / bitTicksFx + 1) : 0;
+    m_bitTicksRecipLimit = (bitTicksFx > 256) ? 1UL << 24 : 0;
+}
+
+void UARTBase::syncTimebase() {
+#ifdef CCY_TICKS
+    const uint32_t mhz = ESP.getCpuFreqMHz();
+    if (mhz == m_bitTicksMHz) return;
+    m_cpuFreqMHz = mhz;
+    if (m_bitTicksMHz) setBitTicksFx(static_cast<uint64_t>(m_bitTicksFx) * mhz / m_bitTicksMHz);
+    m_bitTicksMHz = mhz;
+#endif
+}
+
+void UARTBase::enableCalibration(bool on) {
+    m_calibrate = on;
+    m_calTicks = 0;
+    m_calBits = 0;
+}
+
+void UARTBase::autoBaud(uint16_t edges) {
+    m_calTicks = UINT32_MAX;
+    m_autoBaudEdges = edges;
+}
+
 void UARTBase::beginRx(bool hasPullUp, int bufCapacity, int isrBufCapacity) {
-    m_rxGPIOHasPullUp = hasPullUp;
-    m_rxReg = portInputRegister(digitalPinToPort(m_rxPin));
-    m_rxBitMask = digitalPinToBitMask(m_rxPin);
-    m_buffer.reset(new circular_queue<uint8_t>((bufCapacity > 0) ? bufCapacity : 64));
+    m_buffer = QueuePtr<circular_queue<uint8_t> >(
+        new circular_queue<uint8_t>((bufCapacity > 0) ? bufCapacity : 64));
     if (m_parityMode)
     {
-        m_parityBuffer.reset(new circular_queue<uint8_t>((m_buffer->capacity() + 7) / 8));
+        m_parityBuffer = QueuePtr<circular_queue<uint8_t> >(
+            new circular_queue<uint8_t>((m_buffer->capacity() + 7) / 8));
+    }
+    m_isrBuffer = QueuePtr<circular_queue_pow2<uint32_t, UARTBase*> >(
+        new circular_queue_pow2<uint32_t, UARTBase*>((isrBufCapacity > 0) ?
+            isrBufCapacity : m_buffer->capacity() * (2 + m_dataBits + static_cast<bool>(m_parityMode))));
+    setupRx(hasPullUp);
+}
+
+void UARTBase::beginRx(bool hasPullUp, circular_queue<uint8_t>& buffer, circular_queue<uint8_t>& parityBuffer,
+    circular_queue_pow2<uint32_t, UARTBase*>& isrBuffer) {
+    buffer.flush();
+    m_buffer = QueuePtr<circular_queue<uint8_t> >(&buffer, { false });
+    if (m_parityMode)
+    {
+        parityBuffer.flush();
+        m_parityBuffer = QueuePtr<circular_queue<uint8_t> >(&parityBuffer, { false });
+    }
+    isrBuffer.flush();
+    m_isrBuffer = QueuePtr<circular_queue_pow2<uint32_t, UARTBase*> >(&isrBuffer, { false });
+    setupRx(hasPullUp);
+}
+
+void UARTBase::setupRx(bool hasPullUp) {
+    m_rxGPIOHasPullUp = hasPullUp;
+    m_rxReg = Hal::inputRegister(m_rxPin);
+    m_rxBitMask = Hal::bitMask(m_rxPin);
+    if (m_parityBuffer)
+    {
         m_parityInPos = m_parityOutPos = 1;
     }
-    m_isrBuffer.reset(new circular_queue<uint32_t, UARTBase*>((isrBufCapacity > 0) ?
-        isrBufCapacity : m_buffer->capacity() * (2 + m_dataBits + static_cast<bool>(m_parityMode))));
     if (m_buffer && (!m_parityMode || m_parityBuffer) && m_isrBuffer) {
         m_rxValid = true;
         setRxGPIOPinMode();
@@ -109,21 +290,46 @@ void UARTBase::beginRx(bool hasPullUp, int bufCapacity, int isrBufCapacity) {
 }
 
 void UARTBase::beginTx() {
-#if !defined(ESP8266)
-    m_txReg = portOutputRegister(digitalPinToPort(m_txPin));
-#endif
-    m_txBitMask = digitalPinToBitMask(m_txPin);
+    m_txReg = Hal::outputRegister(m_txPin);
+    m_txBitMask = Hal::bitMask(m_txPin);
+    // Precompute the frames, saving the parity and bit pattern computation per sent byte.
+    // The table is reused by later calls, such that begin() and end() do not fragment the heap.
+    const uint32_t frameCount = 1UL << m_dataBits;
+    if (!m_txFrames) {
+        m_txFrames.reset(new uint16_t[1UL << 8]);
+    }
+    if (m_txFrames) {
+        for (uint32_t byte = 0; byte < frameCount; ++byte) {
+            m_txFrames[byte] = txWord(byte, m_parityMode);
+        }
+    }
     m_txValid = true;
     if (!m_oneWire) {
         setTxGPIOPinMode();
-        digitalWrite(m_txPin, !m_invert);
+        Hal::digitalWrite(m_txPin, !m_invert);
     }
 }
 
 void UARTBase::end()
 {
+    endBackend();
     enableRx(false);
+    if (m_dispatcher) {
+        m_dispatcher->remove(*this);
+    }
+    // complete the async transmit, rather than cutting off a frame
+    if (m_txBuffer) { drainAsyncTx(); }
+    m_rxAlarm.end();
+    m_txAlarm.end();
+    m_txBuffer.reset();
+    enableFrames(false);
+    m_txActive.store(false);
+    m_txBitsLeft = 0;
+    // leave the line idle at stop bit level, and release the bus
+    if (m_txValid && m_txGPIO) { setTxLevel(!m_invert); }
+    if (m_txValid && m_txEnableValid) { setTxEnableLevel(false); }
     m_txValid = false;
+    m_rxValid = false;
     if (m_buffer) {
         m_buffer.reset();
     }
@@ -131,24 +337,155 @@ void UARTBase::end()
     if (m_isrBuffer) {
         m_isrBuffer.reset();
     }
+    // with rx disabled, the pending read completes with the bytes read so far
+    if (RxAwaiter* const awaiter = m_rxAwaiter) {
+        m_rxAwaiter = nullptr;
+        awaiter->complete();
+    }
 }
 
 uint32_t UARTBase::baudRate() {
-    return microsToTicks(1000000UL) / m_bitTicks;
+    return ((static_cast<uint64_t>(microsToTicks(1000000UL)) << 8) + (m_bitTicksFx >> 1)) / m_bitTicksFx;
 }
 
 void UARTBase::setTransmitEnablePin(int8_t txEnablePin) {
     if (-1 != txEnablePin) {
         m_txEnableValid = true;
         m_txEnablePin = txEnablePin;
-        pinMode(m_txEnablePin, OUTPUT);
-        digitalWrite(m_txEnablePin, LOW);
+        m_txEnableReg = Hal::outputRegister(m_txEnablePin);
+        m_txEnableBitMask = Hal::bitMask(m_txEnablePin);
+        Hal::pinMode(m_txEnablePin, OUTPUT);
+        Hal::digitalWrite(m_txEnablePin, LOW);
     }
     else {
         m_txEnableValid = false;
     }
 }
 
+void UARTBase::enableBusMode(bool on, uint32_t gapMicros) {
+    m_busMode = on;
+    m_rxMuted = false;
+    m_busGapMicros = gapMicros;
+    if (on && m_oneWire && m_txValid) {
+        if (m_txGPIOOpenDrain) {
+            // the released open drain output reads the bus level
+            setTxGPIOPinMode();
+            Hal::digitalWrite(m_txPin, !m_invert);
+        }
+        else {
+            setRxGPIOPinMode();
+        }
+        enableRx(true);
+    }
+}
+
+bool UARTBase::busIdle() {
+    if (!m_rxValid) { return true; }
+    rxBits();
+    // 3.5 characters, including the start bits
+    const uint32_t gapTicks = m_busGapMicros ?
+        microsToTicks(m_busGapMicros) : 7 * (m_pduBits + 1) * m_bitTicks / 2;
+    return m_rxLastBit >= m_pduBits - 1 && !m_isrBuffer->available() && ticks() - m_isrLastTick >= gapTicks;
+}
+
+bool UARTBase::acquireBus() {
+    const auto start = Hal::millis();
+    while (!busIdle()) {
+        if (Hal::millis() - start >= _timeout) { return false; }
+        Hal::optimisticYield(1000UL);
+    }
+    if (m_oneWire && !m_txGPIOOpenDrain) {
+        setTxGPIOPinMode();
+        Hal::digitalWrite(m_txPin, !m_invert);
+    }
+    m_rxMuted = true;
+    return true;
+}
+
+void UARTBase::releaseBus() {
+    // only the last bit of the stop level is waited for with interrupts disabled
+    if (m_periodDuration > m_bitTicks) {
+        m_periodDuration -= m_bitTicks;
+        lazyDelay();
+        m_periodDuration = m_bitTicks;
+    }
+    if (m_intTxEnabled) { disableInterrupts(); }
+    preciseDelay();
+    if (m_txEnableValid) { setTxEnableLevel(false); }
+    if (m_rxValid) {
+        // drop any edges left over, and decode from the stop level at the turnaround
+        m_isrBuffer->pop_n(nullptr, m_isrBuffer->available());
+        m_rxLastBit = m_pduBits - 1;
+        m_rxCurByte = 0;
+        m_rxCurParity = false;
+        m_rxIdleBits = 0;
+        m_isrLastTick = (m_periodStart | 1) ^ m_invert;
+    }
+    m_rxMuted = false;
+    if (m_intTxEnabled) { restoreInterrupts(); }
+}
+
+void UARTBase::enableFrames(bool on, uint32_t gapMicros, int frameCapacity) {
+    if (!on) {
+        m_frameWakeup = false;
+        m_frameAlarm.end();
+        m_frames.reset();
+        m_frameLength = 0;
+        return;
+    }
+    if (!m_rxValid) return;
+    setupFrames(QueuePtr<circular_queue<RxFrame> >(
+        new circular_queue<RxFrame>((frameCapacity > 0) ? frameCapacity : 16)), gapMicros);
+}
+
+void UARTBase::enableFrames(circular_queue<RxFrame>& frames, uint32_t gapMicros) {
+    if (!m_rxValid) return;
+    frames.flush();
+    setupFrames(QueuePtr<circular_queue<RxFrame> >(&frames, { false }), gapMicros);
+}
+
+void UARTBase::setupFrames(QueuePtr<circular_queue<RxFrame> >&& frames, uint32_t gapMicros) {
+    m_frames = std::move(frames);
+    m_frameGapBits = gapMicros ?
+        (microsToTicks(gapMicros) + m_bitTicks - 1) / m_bitTicks : (7 * (m_pduBits + 1) + 1) / 2;
+    m_frameOffset = 0;
+    m_frameLength = 0;
+    m_frameExpected = 0;
+    m_frameStatus = 0;
+    m_frameWakeup = m_frameAlarm || m_frameAlarm.begin(reinterpret_cast<void (*)(void*)>(frameAlarmISR), this);
+}
+
+void UARTBase::enableAddressFilter(bool on, uint8_t address, uint8_t mask) {
+    m_addressFilter = on && m_parityMode;
+    m_address = address;
+    m_addressMask = mask;
+    m_rxAddressed = false;
+}
+
+int UARTBase::availableFrames() {
+    if (!m_frames) { return 0; }
+    rxBits();
+    return m_frames->available();
+}
+
+bool UARTBase::readFrame(RxFrame& frame) {
+    if (!availableFrames()) { return false; }
+    frame = m_frames->pop();
+    return true;
+}
+
+void IRAM_ATTR UARTBase::frameAlarmISR(UARTBase* self) {
+    const uint32_t wakeupTicks = self->frameWakeupTicks();
+    const uint32_t idle = ticks() - self->m_rxEdgeTick;
+    if (idle >= wakeupTicks) {
+        self->m_rxHandler();
+    }
+    else {
+        // edges have arrived since arming
+        self->m_frameAlarm.arm(ticksToMicros(wakeupTicks - idle));
+    }
+}
+
 void UARTBase::enableIntTx(bool on) {
     m_intTxEnabled = on;
 }
@@ -163,12 +500,51 @@ void UARTBase::enableTxGPIOOpenDrain(bool on) {
     setTxGPIOPinMode();
 }
 
+void UARTBase::enableAsyncTx(bool on, int txBufCapacity) {
+    drainAsyncTx();
+    if (!on) {
+        m_txAlarm.end();
+        m_txBuffer.reset();
+        return;
+    }
+    if (!m_txValid || !m_txGPIO) return;
+    setupAsyncTx(QueuePtr<circular_queue<uint8_t> >(
+        new circular_queue<uint8_t>((txBufCapacity > 0) ? txBufCapacity : 64)));
+}
+
+void UARTBase::enableAsyncTx(circular_queue<uint8_t>& txBuffer) {
+    drainAsyncTx();
+    if (!m_txValid || !m_txGPIO) return;
+    txBuffer.flush();
+    setupAsyncTx(QueuePtr<circular_queue<uint8_t> >(&txBuffer, { false }));
+}
+
+void UARTBase::setupAsyncTx(QueuePtr<circular_queue<uint8_t> >&& txBuffer) {
+    m_txBuffer = std::move(txBuffer);
+    if (!m_txAlarm && !m_txAlarm.begin(reinterpret_cast<void (*)(void*)>(asyncTxISR), this)) {
+        m_txBuffer.reset();
+    }
+}
+
+void UARTBase::enableTimerRx(bool on) {
+    const bool rxEnabled = m_rxEnabled;
+    enableRx(false);
+    if (on) {
+        m_timerRxEnabled = m_rxAlarm || m_rxAlarm.begin(reinterpret_cast<void (*)(void*)>(rxSampleISR), this);
+    }
+    else {
+        m_rxAlarm.end();
+        m_timerRxEnabled = false;
+    }
+    enableRx(rxEnabled);
+}
+
 void UARTBase::enableTx(bool on) {
     if (m_txValid && m_oneWire) {
         if (on) {
             enableRx(false);
             setTxGPIOPinMode();
-            digitalWrite(m_txPin, !m_invert);
+            Hal::digitalWrite(m_txPin, !m_invert);
         }
         else {
             setRxGPIOPinMode();
@@ -183,13 +559,30 @@ void UARTBase::enableRx(bool on) {
             m_rxLastBit = m_pduBits - 1;
             // Init to stop bit level and current tick
             m_isrLastTick = (ticks() | 1) ^ m_invert;
-            if (m_bitTicks >= microsToTicks(1000000UL) / 74880UL)
-                attachInterruptArg(digitalPinToInterrupt(m_rxPin), reinterpret_cast<void (*)(void*)>(rxBitISR), this, CHANGE);
+            if (!m_rxGPIO) {
+                // the backend captures the edges
+            }
+            else if (m_bitTicks >= microsToTicks(1000000UL) / 74880UL && m_dispatcher)
+                m_dispatcher->enableRx(*this, true);
+            else if (m_bitTicks >= microsToTicks(1000000UL) / 74880UL)
+                Hal::attachInterrupt(m_rxPin, reinterpret_cast<void (*)(void*)>(m_rxBitISR), this, CHANGE);
+            else if (m_timerRxEnabled) {
+                m_rxSampling = false;
+                Hal::attachInterrupt(m_rxPin, reinterpret_cast<void (*)(void*)>(rxStartBitISR), this, m_invert ? RISING : FALLING);
+            }
             else
-                attachInterruptArg(digitalPinToInterrupt(m_rxPin), reinterpret_cast<void (*)(void*)>(rxBitSyncISR), this, m_invert ? RISING : FALLING);
+                Hal::attachInterrupt(m_rxPin, reinterpret_cast<void (*)(void*)>(rxBitSyncISR), this, m_invert ? RISING : FALLING);
         }
-        else {
-            detachInterrupt(digitalPinToInterrupt(m_rxPin));
+        else if (m_rxGPIO) {
+            if (m_dispatcher) {
+                m_dispatcher->enableRx(*this, false);
+            }
+            Hal::detachInterrupt(m_rxPin);
+            if (m_rxAlarm) {
+                m_rxAlarm.disarm();
+                m_rxSampling = false;
+            }
+            if (m_frameWakeup) m_frameAlarm.disarm();
         }
         m_rxEnabled = on;
     }
@@ -223,30 +616,92 @@ int UARTBase::read(uint8_t* buffer, size_t size) {
         avail = m_buffer->pop_n(buffer, size);
     }
     if (!avail) return 0;
-    if (m_parityBuffer) {
-        uint32_t parityBits = avail;
+    popParity(avail);
+    return avail;
+}
+
+size_t UARTBase::readSpans(const uint8_t*& span, size_t& size, const uint8_t*& wrapSpan, size_t& wrapSize) {
+    if (!m_rxValid) {
+        span = wrapSpan = nullptr;
+        size = wrapSize = 0;
+        return 0;
+    }
+    rxBits();
+    uint8_t* block;
+    uint8_t* wrapBlock;
+    const size_t avail = m_buffer->peek_blocks(block, size, wrapBlock, wrapSize);
+    span = block;
+    wrapSpan = wrapBlock;
+    return avail;
+}
+
+size_t UARTBase::consume(size_t n) {
+    if (!m_rxValid) { return 0; }
+    const size_t count = m_buffer->pop_n(nullptr, n);
+    popParity(count);
+    return count;
+}
+
+void UARTBase::popParity(size_t count) {
+    if (m_parityBuffer && count) {
+        uint32_t parityBits = count;
         while (m_parityOutPos >>= 1) ++parityBits;
         m_parityOutPos = (1 << (parityBits % 8));
         m_parityBuffer->pop_n(nullptr, parityBits / 8);
     }
-    return avail;
+}
+
+bool UARTBase::fillRx(RxAwaiter& awaiter) {
+    if (!m_rxValid || awaiter.cancelled()) { return true; }
+    if (awaiter.delimiter < 0) {
+        awaiter.count += read(&awaiter.buffer[awaiter.count], awaiter.size - awaiter.count);
+        return awaiter.count >= awaiter.size;
+    }
+    while (awaiter.count < awaiter.size) {
+        const int val = read();
+        if (val < 0) { return false; }
+        awaiter.buffer[awaiter.count++] = val;
+        if (val == awaiter.delimiter) { break; }
+    }
+    return true;
+}
+
+void UARTBase::setRxResumer(Delegate<void(), void*>&& resumer) {
+    disableInterrupts();
+    m_rxResumer = std::move(resumer);
+    restoreInterrupts();
+}
+
+bool UARTBase::resumeReader() {
+    RxAwaiter* const awaiter = m_rxAwaiter;
+    if (!awaiter) { return false; }
+    // Skip decoding while idle, unless a word is pending its stop bit
+    if (m_rxValid && !awaiter->cancelled() && !m_buffer->available() && !m_isrBuffer->available() &&
+        m_rxLastBit >= m_pduBits - 1) {
+        return false;
+    }
+    if (!fillRx(*awaiter)) { return false; }
+    // the completion may start the next read
+    m_rxAwaiter = nullptr;
+    awaiter->complete();
+    return true;
 }
 
 size_t UARTBase::readBytes(uint8_t* buffer, size_t size) {
     if (!m_rxValid || !size) { return 0; }
     size_t count = 0;
-    auto start = millis();
+    auto start = Hal::millis();
     do {
         auto readCnt = read(&buffer[count], size - count);
         count += readCnt;
         if (count >= size) break;
         if (readCnt) {
-            start = millis();
+            start = Hal::millis();
         }
         else {
-            optimistic_yield(1000UL);
+            Hal::optimisticYield(1000UL);
         }
-    } while (millis() - start < _timeout);
+    } while (Hal::millis() - start < _timeout);
     return count;
 }
 
@@ -255,7 +710,7 @@ int UARTBase::available() {
     rxBits();
     int avail = m_buffer->available();
     if (!avail) {
-        optimistic_yield(10000UL);
+        Hal::optimisticYield(10000UL);
     }
     return avail;
 }
@@ -268,11 +723,11 @@ void UARTBase::lazyDelay() {
     const uint32_t ms = remaining > 0 ? ticksToMicros(remaining) / 1000UL : 0;
     if (ms > 0)
     {
-        delay(ms);
+        Hal::delay(ms);
     }
     else
     {
-        optimistic_yield(10000UL);
+        Hal::optimisticYield(10000UL);
     }
     // Assure that below-ms part of delays are not elided
     preciseDelay();
@@ -285,50 +740,55 @@ void IRAM_ATTR UARTBase::preciseDelay() {
     do {
         now = ticks();
     } while ((now - m_periodStart) < m_periodDuration);
+#ifdef SWSERIAL_STATS
+    if (m_periodDuration) UARTStats::count(m_stats.txOvershoot, now - m_periodStart - m_periodDuration, 0);
+#endif
     m_periodDuration = 0;
     m_periodStart = now;
 }
 
-void IRAM_ATTR UARTBase::writePeriod(
-    uint32_t dutyCycle, uint32_t offCycle, bool withStopBit) {
-    preciseDelay();
-    if (dutyCycle)
+uint32_t IRAM_ATTR UARTBase::txWord(uint8_t byte, Parity parity) const {
+    byte &= ((1UL << m_dataBits) - 1);
+    // push LSB start-data-parity-stop bit pattern into uint32_t
+    // Stop bits: HIGH
+    uint32_t word = ~0U;
+    // inverted parity bit, performance tweak for xor all-bits-set word
+    if (parity && m_parityMode)
     {
-#if defined(ESP8266)
-        if (16 == m_txPin) {
-            GP16O = 1;
-        }
-        else {
-            GPOS = m_txBitMask;
-        }
-#else
-        *m_txReg = *m_txReg | m_txBitMask;
-#endif
-        m_periodDuration += dutyCycle;
-        if (offCycle || (withStopBit && !m_invert)) {
-            if (!withStopBit || m_invert) {
-                preciseDelay();
-            }
-            else {
-                lazyDelay();
-            }
-        }
-    }
-    if (offCycle)
-    {
-#if defined(ESP8266)
-        if (16 == m_txPin) {
-            GP16O = 0;
-        }
-        else {
-            GPOC = m_txBitMask;
+        uint32_t parityBit;
+        switch (parity)
+        {
+        case PARITY_EVEN:
+            // from inverted, so use odd parity
+            parityBit = byte;
+            parityBit ^= parityBit >> 4;
+            parityBit &= 0xf;
+            parityBit = (0x9669 >> parityBit) & 1;
+            break;
+        case PARITY_ODD:
+            // from inverted, so use even parity
+            parityBit = byte;
+            parityBit ^= parityBit >> 4;
+            parityBit &= 0xf;
+            parityBit = (0x6996 >> parityBit) & 1;
+            break;
+        case PARITY_MARK:
+            parityBit = 0;
+            break;
+        case PARITY_SPACE:
+            // suppresses warning parityBit uninitialized
+        default:
+            parityBit = 1;
+            break;
         }
-#else
-        *m_txReg = *m_txReg & ~m_txBitMask;
-#endif
-        m_periodDuration += offCycle;
-        if (withStopBit && m_invert) lazyDelay();
+        word ^= parityBit;
     }
+    word <<= m_dataBits;
+    word |= byte;
+    // Start bit: LOW
+    word <<= 1;
+    if (m_invert) word = ~word;
+    return word;
 }
 
 size_t UARTBase::write(uint8_t byte) {
@@ -346,92 +806,128 @@ size_t UARTBase::write(const uint8_t* buffer, size_t size) {
 size_t IRAM_ATTR UARTBase::write(const uint8_t* buffer, size_t size, Parity parity) {
     if (m_rxValid) { rxBits(); }
     if (!m_txValid) { return -1; }
+    syncTimebase();
 
-    if (m_txEnableValid) {
-        digitalWrite(m_txEnablePin, HIGH);
-    }
-    // Stop bit: if inverted, LOW, otherwise HIGH
-    bool b = !m_invert;
-    uint32_t dutyCycle = 0;
-    uint32_t offCycle = 0;
-    if (!m_intTxEnabled) {
-        // Disable interrupts in order to get a clean transmit timing
-        disableInterrupts();
-    }
-    const uint32_t dataMask = ((1UL << m_dataBits) - 1);
-    bool withStopBit = true;
-    m_periodDuration = 0;
-    m_periodStart = ticks();
-    for (size_t cnt = 0; cnt < size; ++cnt) {
-        uint8_t byte = pgm_read_byte(buffer + cnt) & dataMask;
-        // push LSB start-data-parity-stop bit pattern into uint32_t
-        // Stop bits: HIGH
-        uint32_t word = ~0UL;
-        // inverted parity bit, performance tweak for xor all-bits-set word
-        if (parity && m_parityMode)
-        {
-            uint32_t parityBit;
-            switch (parity)
-            {
-            case PARITY_EVEN:
-                // from inverted, so use odd parity
-                parityBit = byte;
-                parityBit ^= parityBit >> 4;
-                parityBit &= 0xf;
-                parityBit = (0x9669 >> parityBit) & 1;
-                break;
-            case PARITY_ODD:
-                // from inverted, so use even parity
-                parityBit = byte;
-                parityBit ^= parityBit >> 4;
-                parityBit &= 0xf;
-                parityBit = (0x6996 >> parityBit) & 1;
-                break;
-            case PARITY_MARK:
-                parityBit = 0;
-                break;
-            case PARITY_SPACE:
-                // suppresses warning parityBit uninitialized
-            default:
-                parityBit = 1;
-                break;
+    if (m_txBuffer) {
+        if (parity == m_parityMode && !m_busMode) {
+            size_t cnt = 0;
+            for (;;) {
+                while (cnt < size && m_txBuffer->push(pgm_read_byte(buffer + cnt))) ++cnt;
+                startAsyncTx();
+                if (cnt >= size) break;
+                // block only until the tx ISR frees up space
+                Hal::optimisticYield(1000UL);
             }
-            word ^= parityBit;
+            return size;
         }
-        word <<= m_dataBits;
-        word |= byte;
-        // Start bit: LOW
-        word <<= 1;
-        if (m_invert) word = ~word;
-        for (int i = 0; i <= m_pduBits; ++i) {
-            bool pb = b;
-            b = word & (1UL << i);
-            if (!pb && b) {
-                writePeriod(dutyCycle, offCycle, withStopBit);
-                withStopBit = false;
-                dutyCycle = offCycle = 0;
-            }
-            if (b) {
-                dutyCycle += m_bitTicks;
-            }
-            else {
-                offCycle += m_bitTicks;
-            }
+        drainAsyncTx();
+    }
+
+    if (m_busMode && !acquireBus()) { return 0; }
+    if (m_txEnableValid) {
+        setTxEnableLevel(true);
+    }
+    if (writeFrames(buffer, size, parity)) {
+        if (m_busMode) {
+            m_periodDuration = 0;
+            // releaseBus() expects the interrupts disabled unless m_intTxEnabled
+            if (!m_intTxEnabled) { disableInterrupts(); }
+            releaseBus();
+            if (!m_intTxEnabled) { restoreInterrupts(); }
+            if (m_oneWire && !m_txGPIOOpenDrain) { setRxGPIOPinMode(); }
+        }
+        else if (m_txEnableValid) {
+            setTxEnableLevel(false);
         }
-        withStopBit = true;
+        return size;
     }
-    writePeriod(dutyCycle, offCycle, true);
-    if (!m_intTxEnabled) {
-        // restore the interrupt state if applicable
-        restoreInterrupts();
+    (this->*m_writeBits)(buffer, size, parity);
+    if (!m_busMode) {
+        if (m_txEnableValid) {
+            setTxEnableLevel(false);
+        }
     }
-    if (m_txEnableValid) {
-        digitalWrite(m_txEnablePin, LOW);
+    else if (m_oneWire && !m_txGPIOOpenDrain) {
+        setRxGPIOPinMode();
     }
     return size;
 }
 
+size_t UARTBase::writeSpans(uint8_t*& span, size_t& size, uint8_t*& wrapSpan, size_t& wrapSize) {
+    if (!m_txValid || !m_txBuffer) {
+        span = wrapSpan = nullptr;
+        size = wrapSize = 0;
+        return 0;
+    }
+    return m_txBuffer->reserve_blocks(span, size, wrapSpan, wrapSize);
+}
+
+size_t UARTBase::commit(size_t n) {
+    if (!m_txValid || !m_txBuffer) { return 0; }
+    if (m_rxValid) { rxBits(); }
+    const size_t count = m_txBuffer->commit(n);
+    if (count) startAsyncTx();
+    return count;
+}
+
+void UARTBase::startAsyncTx() {
+#ifdef ESP8266
+    disableInterrupts();
+    const bool active = m_txActive.load();
+    m_txActive.store(true);
+    restoreInterrupts();
+    if (active) return;
+#else
+    if (m_txActive.exchange(true)) return;
+#endif
+    if (m_txEnableValid) {
+        setTxEnableLevel(true);
+    }
+    m_txBitsLeft = 0;
+    m_txDeadline = ticks();
+    asyncTxISR(this);
+}
+
+void UARTBase::drainAsyncTx() {
+    while (m_txActive.load()) {
+        Hal::optimisticYield(1000UL);
+    }
+}
+
+void IRAM_ATTR UARTBase::asyncTxISR(UARTBase* self) {
+    if (!self->m_txBitsLeft) {
+        if (!self->m_txBuffer->available()) {
+            // the stop bit of the last frame has completed
+            if (self->m_txEnableValid) {
+                self->setTxEnableLevel(false);
+            }
+            self->m_txActive.store(false);
+#ifdef ESP8266
+            return;
+#else
+            // write() may have queued data on the other core, while m_txActive was still set
+            if (!self->m_txBuffer->available() || self->m_txActive.exchange(true)) return;
+            if (self->m_txEnableValid) {
+                self->setTxEnableLevel(true);
+            }
+#endif
+        }
+        self->m_txWord = self->txFrame(self->m_txBuffer->pop(), self->m_parityMode);
+        self->m_txBitsLeft = self->m_pduBits + 1;
+    }
+    // send the run of equal level bits up to the next level change
+    const bool high = self->m_txWord & 1;
+    const uint8_t bits = txRunLength(self->m_txWord, self->m_txBitsLeft);
+    self->m_txWord >>= bits;
+    self->m_txBitsLeft -= bits;
+    self->setTxLevel(high);
+    self->m_txDeadline += bits * self->m_bitTicks;
+    const int32_t remaining = self->m_txDeadline - ticks();
+    self->m_txAlarm.arm(remaining > 0 ? ticksToMicros(remaining) : 0);
+}
+
 void UARTBase::flush() {
+    drainAsyncTx();
     if (!m_rxValid) { return; }
     m_buffer->flush();
     if (m_parityBuffer)
@@ -439,6 +935,13 @@ void UARTBase::flush() {
         m_parityInPos = m_parityOutPos = 1;
         m_parityBuffer->flush();
     }
+    if (m_frames) {
+        m_frames->flush();
+        m_frameOffset += m_frameLength;
+        m_frameLength = 0;
+        m_frameExpected = 0;
+        m_frameStatus = 0;
+    }
 }
 
 bool UARTBase::overflow() {
@@ -458,115 +961,91 @@ int UARTBase::peek() {
     return val;
 }
 
-void UARTBase::rxBits() {
-#ifdef ESP8266
-    if (m_isrOverflow.load()) {
-        m_overflow = true;
-        m_isrOverflow.store(false);
-    }
-#else
-    if (m_isrOverflow.exchange(false)) {
-        m_overflow = true;
+void UARTBase::frameBytes(const uint8_t* bytes, size_t pushed, size_t size) {
+    if (pushed < size) m_frameStatus |= FRAME_OVERFLOW;
+    for (size_t i = 0; i < pushed; ++i) {
+        ++m_frameLength;
+        if (m_frameLengthPrefix && 1 == m_frameLength) m_frameExpected = bytes[i] + 1;
+        if (m_frameDelimiter == bytes[i]) endFrame(FRAME_DELIMITER);
+        else if (m_frameLength == m_frameExpected) endFrame(FRAME_LENGTH);
+        else if (UINT16_MAX == m_frameLength) endFrame(0);
     }
-#endif
+}
 
-    m_isrBuffer->for_each(m_isrBufferForEachDel);
-
-    // A stop bit can go undetected if leading data bits are at same level
-    // and there was also no next start bit yet, so one word may be pending.
-    // Check that there was no new ISR data received in the meantime, inserting an
-    // extraneous stop level bit out of sequence breaks rx.
-    if (m_rxLastBit < m_pduBits - 1) {
-        const uint32_t detectionTicks = (m_pduBits - 1 - m_rxLastBit) * m_bitTicks;
-        if (!m_isrBuffer->available() && ticks() - m_isrLastTick > detectionTicks) {
-            // Produce faux stop bit level, prevents start bit maldetection
-            // tick's LSB is repurposed for the level bit
-            rxBits(((m_isrLastTick + detectionTicks) | 1) ^ m_invert);
-        }
+void UARTBase::endFrame(uint8_t status) {
+    if (!m_frames->push({ m_frameOffset, m_frameLength, static_cast<uint8_t>(m_frameStatus | status) })) {
+        m_overflow = true;
     }
+    m_frameOffset += m_frameLength;
+    m_frameLength = 0;
+    m_frameExpected = 0;
+    m_frameStatus = 0;
 }
 
-void UARTBase::rxBits(const uint32_t isrTick) {
-    const bool level = (m_isrLastTick & 1) ^ m_invert;
-
-    // error introduced by edge value in LSB of isrTick is negligible
-    uint32_t ticksDiff = isrTick - m_isrLastTick;
-    m_isrLastTick = isrTick;
-
-    uint32_t bits = ticksDiff / m_bitTicks;
-    if (ticksDiff % m_bitTicks > (m_bitTicks >> 1)) ++bits;
-    while (bits > 0) {
-        // start bit detection
-        if (m_rxLastBit >= (m_pduBits - 1)) {
-            // leading edge of start bit?
-            if (level) break;
-            m_rxLastBit = -1;
-            --bits;
-            continue;
-        }
-        // data bits
-        if (m_rxLastBit < (m_dataBits - 1)) {
-            uint8_t dataBits = min(bits, static_cast<uint32_t>(m_dataBits - 1 - m_rxLastBit));
-            m_rxLastBit += dataBits;
-            bits -= dataBits;
-            m_rxCurByte >>= dataBits;
-            if (level) { m_rxCurByte |= (BYTE_ALL_BITS_SET << (8 - dataBits)); }
-            continue;
-        }
-        // parity bit
-        if (m_parityMode && m_rxLastBit == (m_dataBits - 1)) {
-            ++m_rxLastBit;
-            --bits;
-            m_rxCurParity = level;
-            continue;
-        }
-        // stop bits
-        // Store the received value in the buffer unless we have an overflow
-        // if not high stop bit level, discard word
-        if (bits >= static_cast<uint32_t>(m_pduBits - 1 - m_rxLastBit) && level) {
-            m_rxCurByte >>= (sizeof(uint8_t) * 8 - m_dataBits);
-            if (!m_buffer->push(m_rxCurByte)) {
-                m_overflow = true;
+void UARTBase::rxFlush(RxBatch& batch) {
+    const size_t pushed = m_buffer->push_n(batch.bytes, batch.size);
+    if (pushed < batch.size) {
+        m_overflow = true;
+    }
+    if (m_frames) frameBytes(batch.bytes, pushed, batch.size);
+#ifdef SWSERIAL_STATS
+    m_stats.bytes += batch.size;
+    m_stats.bufferOverflows += batch.size - pushed;
+    const uint32_t used = m_buffer->available();
+    if (used > m_stats.bufferHighWater) m_stats.bufferHighWater = used;
+#endif
+    if (m_parityBuffer)
+    {
+        for (size_t i = 0; i < pushed; ++i) {
+            if ((batch.parities >> i) & 1) {
+                m_parityBuffer->pushpeek() |= m_parityInPos;
             }
             else {
-                if (m_parityBuffer)
-                {
-                    if (m_rxCurParity) {
-                        m_parityBuffer->pushpeek() |= m_parityInPos;
-                    }
-                    else {
-                        m_parityBuffer->pushpeek() &= ~m_parityInPos;
-                    }
-                    m_parityInPos <<= 1;
-                    if (!m_parityInPos)
-                    {
-                        m_parityBuffer->push();
-                        m_parityInPos = 1;
-                    }
-                }
+                m_parityBuffer->pushpeek() &= ~m_parityInPos;
+            }
+            m_parityInPos <<= 1;
+            if (!m_parityInPos)
+            {
+                m_parityBuffer->push();
+                m_parityInPos = 1;
             }
         }
-        m_rxLastBit = m_pduBits - 1;
-        // reset to 0 is important for masked bit logic
-        m_rxCurByte = 0;
-        m_rxCurParity = false;
-        break;
     }
+    batch.size = 0;
+    batch.parities = 0;
 }
 
-void IRAM_ATTR UARTBase::rxBitISR(UARTBase* self) {
-    const bool level = *self->m_rxReg & self->m_rxBitMask;
-    const uint32_t curTick = ticks();
-    const bool empty = !self->m_isrBuffer->available();
+void UARTBase::calibrate(uint32_t ticksDiff, uint32_t bits, bool level) {
+    // only intervals from the start bit up to the first stop bit have a known number of bits,
+    // in the stop state, a low level is the start bit
+    int lastBit = m_rxLastBit;
+    if (lastBit >= m_pduBits - 1) {
+        if (level) return;
+        lastBit = -2;
+    }
+    if (!bits || lastBit + static_cast<int>(bits) > m_pduBits - m_stopBits - 1) return;
+    // discard glitches off by more than a quarter bit
+    const int64_t error = (static_cast<int64_t>(ticksDiff) << 8) - static_cast<int64_t>(bits) * m_bitTicksFx;
+    if (4 * (error < 0 ? -error : error) > m_bitTicksFx) return;
+    m_calTicks += ticksDiff;
+    m_calBits += bits;
+    if (m_calBits < 128) return;
+    // move a quarter of the way to the mean bit duration of the window
+    const int32_t mean = (static_cast<uint64_t>(m_calTicks) << 8) / m_calBits;
+    setBitTicksFx(m_bitTicksFx + (mean - static_cast<int32_t>(m_bitTicksFx)) / 4);
+    m_calTicks = 0;
+    m_calBits = 0;
+}
 
-    // Store level and tick in the buffer unless we have an overflow
-    // tick's LSB is repurposed for the level bit
-    if (!self->m_isrBuffer->push((curTick | 1U) ^ !level)) self->m_isrOverflow.store(true);
-    // Trigger rx callback only when receiver is starved
-    if (empty) self->m_rxHandler();
+void IRAM_ATTR UARTBase::rxBitISR(UARTBase* self) {
+    self->rxEdge(*self->m_rxReg & self->m_rxBitMask);
 }
 
 void IRAM_ATTR UARTBase::rxBitSyncISR(UARTBase* self) {
+    if (self->m_rxMuted) return;
+#ifdef SWSERIAL_STATS
+    const uint32_t entry = Hal::cycles();
+#endif
     bool level = self->m_invert;
     const uint32_t start = ticks();
     uint32_t wait = self->m_bitTicks;
@@ -574,7 +1053,7 @@ void IRAM_ATTR UARTBase::rxBitSyncISR(UARTBase* self) {
 
     // Store level and tick in the buffer unless we have an overflow
     // tick's LSB is repurposed for the level bit
-    if (!self->m_isrBuffer->push(((start + wait) | 1U) ^ !level)) self->m_isrOverflow.store(true);
+    if (!self->m_isrBuffer->push(((start + wait) | 1U) ^ !level)) self->isrOverflow();
 
     for (uint32_t i = 0; i < self->m_pduBits; ++i) {
         while (ticks() - start < wait) {};
@@ -584,12 +1063,55 @@ void IRAM_ATTR UARTBase::rxBitSyncISR(UARTBase* self) {
         // tick's LSB is repurposed for the level bit
         if (static_cast<bool>(*self->m_rxReg & self->m_rxBitMask) != level)
         {
-            if (!self->m_isrBuffer->push(((start + wait) | 1U) ^ level)) self->m_isrOverflow.store(true);
+            if (!self->m_isrBuffer->push(((start + wait) | 1U) ^ level)) self->isrOverflow();
             level = !level;
         }
     }
     // Trigger rx callback only when receiver is starved
-    if (empty) self->m_rxHandler();
+    if (empty) self->rxWakeup();
+#ifdef SWSERIAL_STATS
+    UARTStats::count(self->m_stats.isrCycles, Hal::cycles() - entry, 6);
+#endif
+}
+
+void IRAM_ATTR UARTBase::rxStartBitISR(UARTBase* self) {
+    // while sampling the frame, the edges of data bits are of no interest
+    if (self->m_rxSampling || self->m_rxMuted) return;
+    const uint32_t start = ticks();
+    const bool empty = !self->m_isrBuffer->available();
+
+    // Store level and tick in the buffer unless we have an overflow
+    // tick's LSB is repurposed for the level bit
+    if (!self->m_isrBuffer->push((start | 1U) ^ !self->m_invert)) self->isrOverflow();
+
+    self->m_rxSampleStart = start;
+    self->m_rxSampleBit = 0;
+    self->m_rxSampleLevel = self->m_invert;
+    self->m_rxSampling = true;
+    // sample midway into the first data bit
+    self->m_rxAlarm.arm(ticksToMicros(self->m_bitTicks + (self->m_bitTicks >> 1)));
+    // Trigger rx callback only when receiver is starved
+    if (empty) self->rxWakeup();
+}
+
+void IRAM_ATTR UARTBase::rxSampleISR(UARTBase* self) {
+    const bool level = *self->m_rxReg & self->m_rxBitMask;
+    const uint8_t bit = ++self->m_rxSampleBit;
+
+    // Store level and tick of the leading edge of the sampled bit in the buffer unless we have an overflow
+    // tick's LSB is repurposed for the level bit
+    if (level != self->m_rxSampleLevel) {
+        if (!self->m_isrBuffer->push(((self->m_rxSampleStart + bit * self->m_bitTicks) | 1U) ^ !level)) self->isrOverflow();
+        self->m_rxSampleLevel = level;
+    }
+    // after the last stop bit, the next start bit edge rearms sampling
+    if (bit >= self->m_pduBits) {
+        self->m_rxSampling = false;
+        return;
+    }
+    const int32_t remaining = self->m_rxSampleStart + bit * self->m_bitTicks +
+        self->m_bitTicks + (self->m_bitTicks >> 1) - ticks();
+    self->m_rxAlarm.arm(remaining > 0 ? ticksToMicros(remaining) : 0);
 }
 
 void UARTBase::onReceive(const Delegate<void(), void*>& handler) {
@@ -604,16 +1126,359 @@ void UARTBase::onReceive(Delegate<void(), void*>&& handler) {
     restoreInterrupts();
 }
 
+UARTDispatcher::~UARTDispatcher() {
+    while (m_portCount) {
+        remove(*m_ports[m_portCount - 1]);
+    }
+}
+
+bool UARTDispatcher::add(UARTBase& port) {
+    if (port.m_dispatcher) return port.m_dispatcher == this;
+    if (!port.m_rxValid || !port.m_rxGPIO || m_portCount >= MAX_PORTS ||
+        port.m_bitTicks < UARTBase::microsToTicks(1000000UL) / 74880UL ||
+        (m_portCount && port.m_rxReg != m_rxReg)) {
+        return false;
+    }
+    const bool rxEnabled = port.m_rxEnabled;
+    port.enableRx(false);
+    UARTBase::disableInterrupts();
+    m_rxReg = port.m_rxReg;
+    m_ports[m_portCount++] = &port;
+    port.m_dispatcher = this;
+    UARTBase::restoreInterrupts();
+    port.enableRx(rxEnabled);
+    return true;
+}
+
+void UARTDispatcher::remove(UARTBase& port) {
+    if (port.m_dispatcher != this) return;
+    const bool rxEnabled = port.m_rxEnabled;
+    port.enableRx(false);
+    UARTBase::disableInterrupts();
+    m_portCount = std::remove(m_ports, m_ports + m_portCount, &port) - m_ports;
+    port.m_dispatcher = nullptr;
+    UARTBase::restoreInterrupts();
+    port.enableRx(rxEnabled);
+}
+
+void UARTDispatcher::enableRx(UARTBase& port, bool on) {
+    if (on) {
+        UARTBase::disableInterrupts();
+        // Init to stop bit level, same as the decoder's state
+        m_levels = (m_levels & ~port.m_rxBitMask) | (port.m_invert ? 0 : port.m_rxBitMask);
+        m_rxBitMasks |= port.m_rxBitMask;
+        UARTBase::restoreInterrupts();
+        Hal::attachInterrupt(port.m_rxPin, reinterpret_cast<void (*)(void*)>(rxEdgesISR), this, CHANGE);
+    }
+    else {
+        UARTBase::disableInterrupts();
+        m_rxBitMasks &= ~port.m_rxBitMask;
+        UARTBase::restoreInterrupts();
+    }
+}
+
+void UARTDispatcher::onReceive(const Delegate<void(), void*>& handler) {
+    UARTBase::disableInterrupts();
+    m_rxHandler = handler;
+    UARTBase::restoreInterrupts();
+}
+
+void UARTDispatcher::onReceive(Delegate<void(), void*>&& handler) {
+    UARTBase::disableInterrupts();
+    m_rxHandler = std::move(handler);
+    UARTBase::restoreInterrupts();
+}
+
+void IRAM_ATTR UARTDispatcher::rxEdgesISR(UARTDispatcher* self) {
+    const uint32_t levels = *self->m_rxReg;
+    const uint32_t curTick = UARTBase::ticks();
+    const uint32_t changed = (levels ^ self->m_levels) & self->m_rxBitMasks;
+    // the edge was already recorded by the interrupt of a coinciding edge on another pin
+    if (!changed) return;
+    self->m_levels = levels;
+    bool starved = false;
+    for (size_t i = 0; i < self->m_portCount; ++i) {
+        UARTBase* port = self->m_ports[i];
+        if (!(changed & port->m_rxBitMask) || port->m_rxMuted) continue;
+        const bool empty = !port->m_isrBuffer->available();
+        port->pushRxEdge(curTick, levels & port->m_rxBitMask);
+        // Trigger rx callbacks only when receiver is starved
+        if (empty) {
+            port->rxWakeup();
+            starved = true;
+        }
+    }
+    if (starved) self->m_rxHandler();
+}
+
+bool UARTMultiWriter::add(UARTBase& port) {
+    if (std::find(m_ports, m_ports + m_portCount, &port) != m_ports + m_portCount) return true;
+    if (!port.m_txValid || !port.m_txGPIO || port.m_oneWire || m_portCount >= MAX_PORTS ||
+#if defined(ESP8266)
+        // GPIO16 is not on the GPOS/GPOC registers
+        16 == port.m_txPin ||
+#endif
+        (m_portCount && (port.m_txReg != m_ports[0]->m_txReg ||
+            port.m_bitTicks != m_ports[0]->m_bitTicks || port.m_pduBits != m_ports[0]->m_pduBits))) {
+        return false;
+    }
+    m_ports[m_portCount++] = &port;
+    m_txBitMasks |= port.m_txBitMask;
+    return true;
+}
+
+void UARTMultiWriter::remove(UARTBase& port) {
+    m_portCount = std::remove(m_ports, m_ports + m_portCount, &port) - m_ports;
+    m_txBitMasks = 0;
+    for (size_t i = 0; i < m_portCount; ++i) {
+        m_txBitMasks |= m_ports[i]->m_txBitMask;
+    }
+}
+
+size_t UARTMultiWriter::write(const uint8_t* buffer, size_t size) {
+    const uint8_t* buffers[MAX_PORTS];
+    size_t sizes[MAX_PORTS];
+    for (size_t i = 0; i < m_portCount; ++i) {
+        buffers[i] = buffer;
+        sizes[i] = size;
+    }
+    return write(buffers, sizes);
+}
+
+size_t IRAM_ATTR UARTMultiWriter::write(const uint8_t* const buffers[], const size_t sizes[]) {
+    size_t size = 0;
+    for (size_t i = 0; i < m_portCount; ++i) {
+        UARTBase& port = *m_ports[i];
+        if (port.m_rxValid) { port.rxBits(); }
+        if (!port.m_txValid) { return 0; }
+        port.syncTimebase();
+        if (port.m_txBuffer) { port.drainAsyncTx(); }
+        size = max(size, sizes[i]);
+    }
+    if (!size) { return 0; }
+    const UARTBase& lead = *m_ports[0];
+    const uint8_t frameBits = lead.m_pduBits + 1;
+    for (size_t i = 0; i < m_portCount; ++i) {
+        if (m_ports[i]->m_txEnableValid) { m_ports[i]->setTxEnableLevel(true); }
+    }
+    uint32_t deadline = UARTBase::ticks();
+    for (size_t cnt = 0; cnt < size; ++cnt) {
+        // the pins that are high per bit of the frame, merged during the stop bits of the previous frame
+        uint32_t highs[32] = { 0 };
+        for (size_t i = 0; i < m_portCount; ++i) {
+            const UARTBase& port = *m_ports[i];
+            uint32_t word = (cnt < sizes[i]) ?
+                port.txFrame(pgm_read_byte(buffers[i] + cnt), port.m_parityMode) : (port.m_invert ? 0 : ~0U);
+            for (uint8_t bit = 0; bit < frameBits; ++bit, word >>= 1) {
+                if (word & 1) { highs[bit] |= port.m_txBitMask; }
+            }
+        }
+        while (static_cast<int32_t>(UARTBase::ticks() - deadline) < 0) {}
+        if (!lead.m_intTxEnabled) { UARTBase::disableInterrupts(); }
+        // an interrupt before disabling extends the stop bits, not shortens the start bit
+        const uint32_t now = UARTBase::ticks();
+        if (static_cast<int32_t>(now - deadline) > 0) { deadline = now; }
+        for (uint8_t bit = 0; bit < frameBits; ++bit) {
+            while (static_cast<int32_t>(UARTBase::ticks() - deadline) < 0) {}
+            Hal::writeOutputs(lead.m_txPin, highs[bit], m_txBitMasks & ~highs[bit]);
+            deadline += lead.m_bitTicks;
+        }
+        if (!lead.m_intTxEnabled) { UARTBase::restoreInterrupts(); }
+    }
+    // the stop bits of the last frame
+    while (static_cast<int32_t>(UARTBase::ticks() - deadline) < 0) {}
+    for (size_t i = 0; i < m_portCount; ++i) {
+        if (m_ports[i]->m_txEnableValid) { m_ports[i]->setTxEnableLevel(false); }
+    }
+    return size;
+}
+
+#ifdef SWSERIAL_RMT
+RmtUARTBase::~RmtUARTBase() {
+    // UARTBase::~UARTBase() can no longer reach endBackend()
+    end();
+}
+
+void RmtUARTBase::endBackend() {
+    if (m_rmtRxChannel) {
+        rmt_disable(m_rmtRxChannel);
+        rmt_del_channel(m_rmtRxChannel);
+        m_rmtRxChannel = nullptr;
+    }
+    if (m_rmtTx) {
+        rmtDeinit(m_txPin);
+        m_rmtTx = false;
+    }
+    m_rmtRxSymbols.reset();
+}
+
+void RmtUARTBase::beginRmtRx(rmt_reserve_memsize_t memsize) {
+    if (!m_rxValid) return;
+    m_rxGPIO = false;
+    m_rmtTickTicks = max(microsToTicks(1) >> 1, 1U);
+    // a capture is complete once the line has been idle for longer than any in-frame level
+    m_rmtIdleTicks = min((m_pduBits + 1) * m_bitTicks, RMT_MAX_DURATION * m_rmtTickTicks);
+    m_rmtRxCapacity = memsize * SOC_RMT_MEM_WORDS_PER_CHANNEL;
+    m_rmtRxSymbols.reset(new rmt_symbol_word_t[m_rmtRxCapacity]);
+    rmt_rx_channel_config_t config{};
+    config.gpio_num = static_cast<gpio_num_t>(m_rxPin);
+    config.clk_src = RMT_CLK_SRC_DEFAULT;
+    config.resolution_hz = RMT_FREQUENCY;
+    config.mem_block_symbols = m_rmtRxCapacity;
+    rmt_rx_event_callbacks_t callbacks{};
+    callbacks.on_recv_done = rmtRxDoneISR;
+    m_rmtRxConfig.signal_range_min_ns = RMT_GLITCH_NS;
+    m_rmtRxConfig.signal_range_max_ns = m_rmtIdleTicks / m_rmtTickTicks * (1000000000UL / RMT_FREQUENCY);
+    if (!m_rmtRxSymbols || ESP_OK != rmt_new_rx_channel(&config, &m_rmtRxChannel)) {
+        m_rmtRxChannel = nullptr;
+        m_rmtRxSymbols.reset();
+        m_rxValid = false;
+        return;
+    }
+    if (ESP_OK != rmt_rx_register_event_callbacks(m_rmtRxChannel, &callbacks, this) ||
+        ESP_OK != rmt_enable(m_rmtRxChannel) || !restartRmtRx()) {
+        rmt_del_channel(m_rmtRxChannel);
+        m_rmtRxChannel = nullptr;
+        m_rmtRxSymbols.reset();
+        m_rxValid = false;
+    }
+}
+
+void RmtUARTBase::beginRmtTx() {
+    if (!m_txValid) return;
+    m_txGPIO = false;
+    m_rmtTickTicks = max(microsToTicks(1) >> 1, 1U);
+    if (!rmtInit(m_txPin, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, RMT_FREQUENCY) ||
+        !rmtSetEOT(m_txPin, !m_invert)) {
+        m_txValid = false;
+        return;
+    }
+    m_rmtTx = true;
+}
+
+bool IRAM_ATTR RmtUARTBase::restartRmtRx() {
+    return ESP_OK == rmt_receive(m_rmtRxChannel, m_rmtRxSymbols.get(),
+        m_rmtRxCapacity * sizeof(rmt_symbol_word_t), &m_rmtRxConfig);
+}
+
+bool IRAM_ATTR RmtUARTBase::rmtRxDoneISR(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t* event, void* self) {
+    (void)channel;
+    RmtUARTBase* const uart = static_cast<RmtUARTBase*>(self);
+    // the capture completed just now, after the idle detection
+    const uint32_t now = ticks();
+    const rmt_symbol_word_t* const symbols = event->received_symbols;
+    const size_t count = event->num_symbols;
+    // a zero duration ends the capture, without it the burst overran the receive memory
+    uint32_t capture = uart->m_rmtIdleTicks;
+    bool ended = count < uart->m_rmtRxCapacity;
+    for (size_t i = 0; i < count && !ended; ++i) {
+        ended = !symbols[i].duration0 || !symbols[i].duration1;
+    }
+    if (!ended) {
+        // the time of the edges is unknown, after the receiver stopped storing them
+        uart->isrOverflow();
+    }
+    else if (uart->m_rxEnabled && uart->m_isrBuffer) {
+        for (size_t i = 0; i < count; ++i) {
+            capture += (symbols[i].duration0 + symbols[i].duration1) * uart->m_rmtTickTicks;
+        }
+        const bool empty = !uart->m_isrBuffer->available();
+        uint32_t tick = now - capture;
+        bool level = !uart->m_invert;
+        for (size_t i = 0; i < count; ++i) {
+            const auto& symbol = symbols[i];
+            if (static_cast<bool>(symbol.level0) != level) {
+                level = symbol.level0;
+                uart->pushRxEdge(tick, level);
+            }
+            tick += symbol.duration0 * uart->m_rmtTickTicks;
+            if (!symbol.duration0) break;
+            if (static_cast<bool>(symbol.level1) != level) {
+                level = symbol.level1;
+                uart->pushRxEdge(tick, level);
+            }
+            tick += symbol.duration1 * uart->m_rmtTickTicks;
+            if (!symbol.duration1) break;
+        }
+        // the line is idle at stop bit level
+        if (level == uart->m_invert) {
+            uart->pushRxEdge(tick, !uart->m_invert);
+        }
+        // Trigger rx callback only when receiver is starved
+        if (empty && count) uart->rxWakeup();
+    }
+    uart->restartRmtRx();
+    return false;
+}
+
+bool RmtUARTBase::writeFrames(const uint8_t* buffer, size_t size, Parity parity) {
+    if (!m_rmtTx) return false;
+    rmt_data_t symbols[RMT_TX_SYMBOLS];
+    size_t count = 0;
+    bool second = false;
+    const uint32_t bitDuration = m_bitTicks / m_rmtTickTicks;
+    for (size_t cnt = 0; cnt < size; ++cnt) {
+        // between frames, the line idles at stop bit level, so the frames can be sent in chunks
+        if (count + m_pduBits + 1 >= RMT_TX_SYMBOLS) {
+            if (second) {
+                symbols[count].level1 = !m_invert;
+                symbols[count++].duration1 = 0;
+                second = false;
+            }
+            rmtWrite(m_txPin, symbols, count, RMT_WAIT_FOR_EVER);
+            count = 0;
+        }
+        uint32_t word = txFrame(pgm_read_byte(buffer + cnt), parity);
+        for (uint8_t bitsLeft = m_pduBits + 1; bitsLeft;) {
+            const bool level = word & 1;
+            const uint8_t bits = txRunLength(word, bitsLeft);
+            word >>= bits;
+            bitsLeft -= bits;
+            for (uint32_t duration = bits * bitDuration; duration;) {
+                const uint32_t part = min(duration, RMT_MAX_DURATION);
+                duration -= part;
+                if (!second) {
+                    symbols[count].level0 = level;
+                    symbols[count].duration0 = part;
+                }
+                else {
+                    symbols[count].level1 = level;
+                    symbols[count].duration1 = part;
+                    if (++count >= RMT_TX_SYMBOLS) {
+                        // only at very low bitrates, a frame needs more symbols than fit
+                        rmtWrite(m_txPin, symbols, count, RMT_WAIT_FOR_EVER);
+                        count = 0;
+                    }
+                }
+                second = !second;
+            }
+        }
+    }
+    if (second) {
+        symbols[count].level1 = !m_invert;
+        symbols[count++].duration1 = 0;
+    }
+    if (count) {
+        rmtWrite(m_txPin, symbols, count, RMT_WAIT_FOR_EVER);
+    }
+    return true;
+}
+#endif // SWSERIAL_RMT
+
 #if __GNUC__ < 12
 // The template member functions below must be in IRAM, but due to a bug GCC doesn't currently
 // honor the attribute. Instead, it is possible to do explicit specialization and adorn
 // these with the IRAM attribute:
-// Delegate<>::operator (), circular_queue<>::available,
-// circular_queue<>::available_for_push, circular_queue<>::push_peek, circular_queue<>::push
+// Delegate<>::operator (), UARTBase::writeBits<>, circular_queue<>::available,
+// circular_queue<>::available_for_push, circular_queue<>::push_peek, circular_queue<>::push,
+// circular_queue<>::pop
 
 template void IRAM_ATTR delegate::detail::DelegateImpl<void*, void>::operator()() const;
-template size_t IRAM_ATTR circular_queue<uint32_t, UARTBase*>::available() const;
-template bool IRAM_ATTR circular_queue<uint32_t, UARTBase*>::push(uint32_t&&);
-template bool IRAM_ATTR circular_queue<uint32_t, UARTBase*>::push(const uint32_t&);
+template void IRAM_ATTR UARTBase::writeBits<UARTBase::ConfiguredFrame>(const uint8_t*, size_t, Parity);
+template size_t IRAM_ATTR circular_queue<uint32_t, UARTBase*, true>::available() const;
+template size_t IRAM_ATTR circular_queue<uint8_t>::available() const;
+template uint8_t IRAM_ATTR circular_queue<uint8_t>::pop();
+template bool IRAM_ATTR circular_queue<uint32_t, UARTBase*, true>::push(uint32_t&&);
+template bool IRAM_ATTR circular_queue<uint32_t, UARTBase*, true>::push(const uint32_t&);
 #endif // __GNUC__ < 12
 
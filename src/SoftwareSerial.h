@@ -23,14 +23,41 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "circular_queue/circular_queue.h"
 #include <Stream.h>
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#include "circular_queue/cancellation_token.h"
+#include "circular_queue/executor.h"
+#include "circular_queue/task.h"
+#endif
+#if defined(ESP32)
+#include <esp_timer.h>
+#include <esp_arduino_version.h>
+#include <soc/gpio_reg.h>
+#include <soc/soc_caps.h>
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+#include <esp32-hal-rmt.h>
+#include <driver/rmt_rx.h>
+#define SWSERIAL_RMT 1
+#endif
+#endif
 
-// Define lets bittiming calculation be based on cpu cycles instead
-// microseconds. This has higher resolution and general precision under
-// low-load conditions, but whenever the CPU frequency gets switched,
-// like during WiFi operation, it in turn is much more imprecise.
-// TODO: increase average timing precision in CCY mode by computing
-// bit durations in 10ths of micros.
-#undef CCY_TICKS
+// Define CCY_TICKS to base the bit timing on CPU cycles instead of microseconds.
+// This has higher resolution, and saves the micros() call on every rx edge.
+// Switches of the CPU frequency, like during WiFi operation, are tracked at
+// the start of each read and write, which only garbles the frames in flight.
+// On multi-core ESP32 variants, the cycle counters of the cores are not in step,
+// keep the rx interrupt on the core that reads from the port.
+//#define CCY_TICKS
+
+// Define SWSERIAL_STATS to keep per-port UARTStats counters and histograms.
+//#define SWSERIAL_STATS
+
+// Define SWSERIAL_SIM to replace the ESP GPIO, interrupt and time primitives by SimHal,
+// a simulated time base and GPIO wiring for running and profiling the UARTs on a host.
+//#define SWSERIAL_SIM
+#if defined(SWSERIAL_SIM) && defined(CCY_TICKS)
+#error "SWSERIAL_SIM keeps time in microseconds, CCY_TICKS is not supported"
+#endif
 
 //#define ALLOW_STRAPPING_PINS // Add to your code if you want to use the strapping pins for SoftwareSerial, too. Use at your own risk!
 
@@ -119,6 +146,166 @@ public:
     }
 };
 
+// Interface definition for the Hal policy, the GPIO, interrupt and time primitives used by UARTBase
+class IHal {
+public:
+    // free-running time base of the bit timing, the LSB is always 0
+    static uint32_t ticks();
+    // free-running CPU cycle count, for profiling
+    static uint32_t cycles();
+    static uint32_t millis();
+    static void delay(uint32_t ms);
+    static void optimisticYield(uint32_t intervalMicros);
+    static void pinMode(int8_t pin, uint8_t mode);
+    static void digitalWrite(int8_t pin, bool high);
+    static volatile uint32_t* inputRegister(int8_t pin);
+    static volatile uint32_t* outputRegister(int8_t pin);
+    static uint32_t bitMask(int8_t pin);
+    // set or clear the bitMask bits of the output register reg of pin
+    static void writeOutput(volatile uint32_t* reg, int8_t pin, uint32_t bitMask, bool high);
+    // set the setMask and clear the clearMask bits of the output register of pin, by one write each
+    static void writeOutputs(int8_t pin, uint32_t setMask, uint32_t clearMask);
+    static void attachInterrupt(int8_t pin, void (*isr)(void*), void* arg, int mode);
+    static void detachInterrupt(int8_t pin);
+};
+
+class EspHal : private IHal {
+public:
+    static inline uint32_t IRAM_ATTR ticks() ALWAYS_INLINE_ATTR {
+#ifdef CCY_TICKS
+        return ESP.getCycleCount() << 1;
+#else
+        return ::micros() << 1;
+#endif // CCY_TICKS
+    }
+    static inline uint32_t IRAM_ATTR cycles() ALWAYS_INLINE_ATTR {
+        return ESP.getCycleCount();
+    }
+    static inline uint32_t millis() {
+        return ::millis();
+    }
+    static inline void delay(uint32_t ms) {
+        ::delay(ms);
+    }
+    static inline void optimisticYield(uint32_t intervalMicros) {
+        optimistic_yield(intervalMicros);
+    }
+    static inline void pinMode(int8_t pin, uint8_t mode) {
+        ::pinMode(pin, mode);
+    }
+    static inline void IRAM_ATTR digitalWrite(int8_t pin, bool high) {
+        ::digitalWrite(pin, high);
+    }
+    static inline volatile uint32_t* IRAM_ATTR inputRegister(int8_t pin) ALWAYS_INLINE_ATTR {
+        return portInputRegister(digitalPinToPort(pin));
+    }
+    static inline volatile uint32_t* outputRegister(int8_t pin) {
+        return portOutputRegister(digitalPinToPort(pin));
+    }
+    static inline uint32_t IRAM_ATTR bitMask(int8_t pin) ALWAYS_INLINE_ATTR {
+        return digitalPinToBitMask(pin);
+    }
+    static inline void IRAM_ATTR writeOutput(volatile uint32_t* reg, int8_t pin, uint32_t bitMask, bool high) ALWAYS_INLINE_ATTR {
+#if defined(ESP8266)
+        (void)reg;
+        if (16 == pin) {
+            GP16O = high;
+        }
+        else if (high) {
+            GPOS = bitMask;
+        }
+        else {
+            GPOC = bitMask;
+        }
+#else
+        (void)pin;
+        if (high) {
+            *reg = *reg | bitMask;
+        }
+        else {
+            *reg = *reg & ~bitMask;
+        }
+#endif
+    }
+    static inline void IRAM_ATTR writeOutputs(int8_t pin, uint32_t setMask, uint32_t clearMask) ALWAYS_INLINE_ATTR {
+#if defined(ESP8266)
+        (void)pin;
+        if (setMask) { GPOS = setMask; }
+        if (clearMask) { GPOC = clearMask; }
+#elif defined(ESP32)
+#if SOC_GPIO_PIN_COUNT > 32
+        if (pin >= 32) {
+            if (setMask) { REG_WRITE(GPIO_OUT1_W1TS_REG, setMask); }
+            if (clearMask) { REG_WRITE(GPIO_OUT1_W1TC_REG, clearMask); }
+            return;
+        }
+#endif
+        if (setMask) { REG_WRITE(GPIO_OUT_W1TS_REG, setMask); }
+        if (clearMask) { REG_WRITE(GPIO_OUT_W1TC_REG, clearMask); }
+#else
+        volatile uint32_t* reg = outputRegister(pin);
+        *reg = (*reg | setMask) & ~clearMask;
+#endif
+    }
+    static inline void attachInterrupt(int8_t pin, void (*isr)(void*), void* arg, int mode) {
+        attachInterruptArg(digitalPinToInterrupt(pin), isr, arg, mode);
+    }
+    static inline void detachInterrupt(int8_t pin) {
+        ::detachInterrupt(digitalPinToInterrupt(pin));
+    }
+};
+
+}; // namespace EspSoftwareSerial
+
+#ifdef SWSERIAL_SIM
+#include "SoftwareSerialSim.h"
+#endif
+
+namespace EspSoftwareSerial {
+
+// The GPIO, interrupt and time primitives of all UARTs, selected at compile time
+#ifdef SWSERIAL_SIM
+using Hal = SimHal;
+#else
+using Hal = EspHal;
+#endif
+static_assert(std::is_base_of<IHal, Hal>::value, "Hal is not derived from IHal");
+
+/// One-shot alarm that invokes its handler in interrupt context.
+/// On ESP32, each alarm is backed by its own esp_timer. On ESP8266, all alarms
+/// share the timer1 peripheral, which is then unavailable to other users,
+/// like analogWrite(), tone(), or Servo, while any alarm is set up.
+class TimerAlarm {
+public:
+    TimerAlarm() = default;
+    TimerAlarm(const TimerAlarm&) = delete;
+    TimerAlarm& operator= (const TimerAlarm&) = delete;
+    ~TimerAlarm();
+    /// @returns true if the alarm is set up, false if no timer resource was available.
+    bool begin(void (*handler)(void*), void* arg);
+    void end();
+    /// Arm the alarm to fire once after the delay, replacing any pending deadline.
+    void arm(uint32_t delayMicros);
+    void disarm();
+    explicit operator bool() const;
+
+private:
+#if defined(ESP8266)
+    // Reprogram timer1 for the earliest deadline of all armed alarms. Call with interrupts disabled.
+    static void reschedule();
+    static void timer1ISR();
+    static TimerAlarm* s_first;
+    static bool s_dispatching;
+    TimerAlarm* m_next = nullptr;
+    void (*m_handler)(void*) = nullptr;
+    void* m_arg = nullptr;
+    uint32_t m_due = 0;
+    bool m_armed = false;
+#else
+    esp_timer_handle_t m_timer = nullptr;
+#endif
+};
+
 enum Parity : uint8_t {
     PARITY_NONE = 000,
     PARITY_EVEN = 020,
@@ -170,6 +357,66 @@ enum Config {
     SWSERIAL_8S2,
 };
 
+/// The status flags of a received frame.
+enum FrameStatus : uint8_t {
+    /// ended by the line being idle for the frame gap
+    FRAME_IDLE = 001,
+    /// ended by the delimiter, which is its last byte
+    FRAME_DELIMITER = 002,
+    /// ended after the number of bytes given by its length prefix
+    FRAME_LENGTH = 004,
+    /// some of its bytes were lost to a full receive buffer
+    FRAME_OVERFLOW = 010,
+    /// some of its words were discarded for a missing stop bit
+    FRAME_ERROR = 020,
+};
+
+/// Descriptor of a received frame, whose bytes are the next length bytes in the receive buffer.
+struct RxFrame {
+    /// the running count of received bytes before the frame, for detecting lost descriptors
+    uint32_t offset;
+    uint16_t length;
+    /// FrameStatus flags
+    uint8_t status;
+};
+
+#ifdef SWSERIAL_STATS
+/// Health counters of a port. Each field has a single writer, either the rx ISR or the
+/// context that reads from the port, so they can be read at any time without locking.
+struct UARTStats {
+    static constexpr size_t HISTOGRAM_BUCKETS = 8;
+    /// Count a value into the histogram buckets below 2^shift, 2^(shift + 1), ..., the last one taking the rest.
+    static inline void IRAM_ATTR count(uint32_t(&histogram)[HISTOGRAM_BUCKETS], uint32_t value, unsigned shift) ALWAYS_INLINE_ATTR {
+        const uint32_t scaled = value >> shift;
+        const size_t bucket = scaled ? 32 - __builtin_clz(scaled) : 0;
+        ++histogram[bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1];
+    }
+    /// rx edges decoded
+    uint32_t edges;
+    /// rx edges lost to a full ISR buffer
+    uint32_t isrOverflows;
+    /// words received, including those of parity errors
+    uint32_t bytes;
+    /// words discarded for a missing stop bit
+    uint32_t framingErrors;
+    /// not counted with the address filter, that uses the parity bit as the 9th data bit
+    uint32_t parityErrors;
+    /// words lost to a full byte buffer
+    uint32_t bufferOverflows;
+    /// words discarded by the address filter
+    uint32_t filteredWords;
+    uint32_t isrBufferHighWater;
+    uint32_t bufferHighWater;
+    /// Durations of the rx edge ISRs in CPU cycles, from below 64 cycles to 4096 and more
+    uint32_t isrCycles[HISTOGRAM_BUCKETS];
+    /// Overshoot of the synchronous tx bit timing past the bit edges in ticks, from 0 to 64 and more
+    uint32_t txOvershoot[HISTOGRAM_BUCKETS];
+};
+#endif
+
+class UARTDispatcher;
+class UARTMultiWriter;
+
 /// This class is compatible with the corresponding AVR one, however,
 /// the constructor takes no arguments, for compatibility with the
 /// HardwareSerial class.
@@ -195,21 +442,101 @@ public:
     /// @param bufCapacity the capacity for the received bytes buffer
     /// @param isrBufCapacity 0: derived from bufCapacity. The capacity of the internal asynchronous
     ///        bit receive buffer, a suggested size is bufCapacity times the sum of
-    ///        start, data, parity and stop bit count.
+    ///        start, data, parity and stop bit count. It is rounded up to a power of two.
     void begin(uint32_t baud, Config config,
         int8_t rxPin, int8_t txPin, bool invert);
 
+    /// @returns the baud rate, as refined by calibration or auto baud detection.
     uint32_t baudRate();
-    /// Transmit control pin.
+    /// Enable or disable (default) the continuous calibration of the bit duration from the edges
+    /// inside received frames, tracking senders whose clock deviates by a few percent from the
+    /// nominal baud rate. This works on the captured GPIO edges, not with timer rx or RMT.
+    void enableCalibration(bool on);
+    /// Detect the baud rate from the shortest of the next edge intervals, which must include
+    /// single bit periods, like the start bit of any odd octet. The octets received during
+    /// detection are discarded, then calibration takes over.
+    /// @param edges the number of edge intervals to analyze
+    void autoBaud(uint16_t edges = 64);
+    /// @returns true while auto baud detection is in progress.
+    bool isAutoBauding() const { return m_autoBaudEdges; }
+    /// Transmit control pin. It is driven high for the duration of each write.
     void setTransmitEnablePin(int8_t txEnablePin);
+    /// Enable or disable (default) the half-duplex bus mode, like for RS-485.
+    /// Each write() is then sent synchronously, after waiting, up to the stream timeout,
+    /// for the rx line to be idle for the inter-frame gap, and otherwise sends nothing.
+    /// The rx interrupt stays attached during the transmission. The transmit enable pin is
+    /// released at the end of the last stop bit, and in the same critical section,
+    /// the decoder discards the echo of the own frames and rearms at the stop level.
+    /// In one-wire mode, with enableTxGPIOOpenDrain(true), the pin mode never changes,
+    /// otherwise the pin is switched to input right after the turnaround.
+    /// @param gapMicros the inter-frame gap, 0 is 3.5 characters, as for Modbus RTU
+    void enableBusMode(bool on, uint32_t gapMicros = 0);
+    /// @returns true if no frame is being received, and the rx line has been idle
+    /// since the end of the last one, or the last own transmission in bus mode, for the inter-frame gap.
+    bool busIdle();
     /// Enable (default) or disable interrupts during tx.
     void enableIntTx(bool on);
     /// Enable (default) or disable internal rx GPIO pull-up.
     void enableRxGPIOPullUp(bool on);
     /// Enable or disable (default) tx GPIO output mode.
     void enableTxGPIOOpenDrain(bool on);
+    /// Enable or disable (default) asynchronous, interrupt-driven tx.
+    /// Once enabled, write() only queues the bytes and returns, while a timer
+    /// interrupt sends them in the background. A write() with a parity other
+    /// than the configured one is sent synchronously, after the queue has drained.
+    /// Must be called after begin().
+    /// @param txBufCapacity the capacity for the queued bytes buffer
+    void enableAsyncTx(bool on, int txBufCapacity = 64);
+    /// Enable asynchronous tx, as by enableAsyncTx(true), on a user-provided buffer
+    /// instead of one on the heap. The buffer must outlive the object.
+    /// @param txBuffer the queued bytes buffer, any previous contents are discarded
+    void enableAsyncTx(circular_queue<uint8_t>& txBuffer);
+    /// Enable or disable (default) timer sampled rx for bitrates above 74880bps.
+    /// Instead of busy-waiting in the GPIO interrupt for the duration of a whole frame,
+    /// the start bit edge arms a timer interrupt that samples each following bit mid-way,
+    /// which keeps every interrupt short and allows several high speed instances at once.
+    /// On ESP32, this requires the esp_timer ISR dispatch method to be available.
+    void enableTimerRx(bool on);
 
     bool overflow();
+    /// Enable or disable (default) the delivery of received frames. Frames are delimited
+    /// by the rx line being idle for the frame gap, and optionally by setFrameDelimiter()
+    /// or enableFrameLengthPrefix(). With a timer available, onReceive() then triggers
+    /// once per burst of frames, when the line has become idle, instead of on its first edge.
+    /// On the ESP8266, this timer is timer1, shared with async tx.
+    /// Must be called after begin().
+    /// @param gapMicros the idle time that ends a frame, 0 is 3.5 characters, as for Modbus RTU
+    /// @param frameCapacity the capacity for the completed frames' descriptors
+    void enableFrames(bool on, uint32_t gapMicros = 0, int frameCapacity = 16);
+    /// Enable the delivery of received frames, as by enableFrames(true), with the descriptors
+    /// in a user-provided queue instead of one on the heap. The queue must outlive the object.
+    /// @param frames the completed frames' descriptors, any previous contents are discarded
+    /// @param gapMicros the idle time that ends a frame, 0 is 3.5 characters, as for Modbus RTU
+    void enableFrames(circular_queue<RxFrame>& frames, uint32_t gapMicros = 0);
+    /// End each frame with the delimiter byte, or only by the frame gap if -1 (default).
+    void setFrameDelimiter(int delimiter) { m_frameDelimiter = delimiter; }
+    /// Enable or disable (default) that the first byte of each frame is the number of the bytes following it.
+    void enableFrameLengthPrefix(bool on) { m_frameLengthPrefix = on; }
+    /// Enable or disable (default) the address filter for 9-bit multidrop protocols, like MDB,
+    /// that send the parity bit as the 9th bit: PARITY_MARK for address words, PARITY_SPACE for data words.
+    /// Only the address words that match address in the bits set in mask, and the data words
+    /// following such an address word, are received, readParity() tells them apart.
+    /// All other words are discarded by the decoder, before they reach the receive buffer.
+    /// onReceive() still triggers on any reception, which is decoded outside of the interrupt.
+    /// Requires a Config with parity.
+    void enableAddressFilter(bool on, uint8_t address = 0, uint8_t mask = 0xff);
+    /// @returns The number of completed frames
+    int availableFrames();
+    /// Take the descriptor of the oldest completed frame. Its bytes are then read by
+    /// read() or readSpans(), the same as without frame delivery.
+    /// @returns false if there is no completed frame
+    bool readFrame(RxFrame& frame);
+#ifdef SWSERIAL_STATS
+    /// @returns the counters of this port, which keep changing while it is active.
+    const UARTStats& stats() const { return m_stats; }
+    /// Zero the counters, increments by the rx ISR during the reset may be lost.
+    void resetStats() { m_stats = UARTStats{}; }
+#endif
 
     int available() override;
 #if defined(ESP8266)
@@ -218,6 +545,7 @@ public:
     int availableForWrite() {
 #endif
         if (!m_txValid) return 0;
+        if (m_txBuffer) return m_txBuffer->available_for_push();
         return 1;
     }
     int peek() override;
@@ -257,6 +585,18 @@ public:
     size_t readBytes(char* buffer, size_t size) override {
         return readBytes(reinterpret_cast<uint8_t*>(buffer), size);
     }
+    /// Zero-copy access to the received bytes, in the order of reception, as the
+    /// contiguous span of the next bytes that read() returns, followed by the span of bytes
+    /// that wrap around in the buffer, which is empty unless needed.
+    /// The bytes remain in the buffer until consume() is called, and the spans stay valid until then.
+    /// @returns The total number of bytes in both spans
+    size_t readSpans(const uint8_t*& span, size_t& size, const uint8_t*& wrapSpan, size_t& wrapSize);
+    /// Removes bytes, as accessed by readSpans(), from the received bytes buffer,
+    /// the same as read(nullptr, n) would.
+    /// @returns The number of bytes removed, up to n
+    size_t consume(size_t n);
+    /// Waits until all asynchronously queued bytes are sent, then discards
+    /// the received bytes buffer.
     void flush() override;
     size_t write(uint8_t byte) override;
     size_t write(uint8_t byte, Parity parity);
@@ -268,6 +608,16 @@ public:
     size_t write(const char* buffer, size_t size, Parity parity) {
         return write(reinterpret_cast<const uint8_t*>(buffer), size, parity);
     }
+    /// Zero-copy access to the free space of the asynchronous tx queue, for serializing frames
+    /// in place. Provides the contiguous span that is sent next, followed by the span that
+    /// wraps around in the queue, which is empty unless needed.
+    /// The bytes are sent, in order, only on commit(). Requires enableAsyncTx(true), otherwise
+    /// both spans are empty.
+    /// @returns The total number of bytes in both spans
+    size_t writeSpans(uint8_t*& span, size_t& size, uint8_t*& wrapSpan, size_t& wrapSize);
+    /// Sends bytes, as written in place into the spans from writeSpans(), with the configured parity.
+    /// @returns The number of bytes queued for sending, up to n
+    size_t commit(size_t n);
     operator bool() const {
         return (-1 == m_rxPin || m_rxValid) && (-1 == m_txPin || m_txValid) && !(-1 == m_rxPin && m_oneWire);
     }
@@ -301,17 +651,159 @@ public:
     [[deprecated("function removed; semantics of onReceive() changed; check the header file.")]]
     void perform_work();
 
+    /// A pending read into a buffer, that completes when size bytes, or with a delimiter,
+    /// up to and including the delimiter, have been read, or it is cancelled.
+    struct RxAwaiter {
+        RxAwaiter(uint8_t* _buffer, size_t _size, int _delimiter) :
+            buffer(_buffer), size(_size), delimiter(_delimiter) {}
+        /// @returns true to complete the read with the bytes read so far
+        virtual bool cancelled() const { return false; }
+        /// Called by resumeReader() on completion, or by end()
+        virtual void complete() = 0;
+        uint8_t* buffer;
+        size_t size;
+        /// -1 for none, otherwise the byte value that completes the read
+        int delimiter;
+        size_t count = 0;
+    protected:
+        ~RxAwaiter() = default;
+    };
+    /// Reads as many bytes as are decoded into the pending read, never blocks.
+    /// @returns true if the read is complete
+    bool fillRx(RxAwaiter& awaiter);
+    /// Makes the read pending until resumeReader() completes it, or end() with the bytes read so far.
+    /// @returns false if another read is already pending, which is left as is
+    bool awaitRx(RxAwaiter& awaiter) {
+        if (m_rxAwaiter && m_rxAwaiter != &awaiter) { return false; }
+        m_rxAwaiter = &awaiter;
+        // a word may be in reception, whose edges have already been captured
+        if (m_rxResumer) { m_rxResumer(); }
+        return true;
+    }
+    /// Withdraws the read, if it is pending, without completing it.
+    void cancelRx(RxAwaiter& awaiter) {
+        if (m_rxAwaiter == &awaiter) { m_rxAwaiter = nullptr; }
+    }
+    /// Completes the pending read, for instance of a coroutine awaiting readAsync() or readUntil(),
+    /// once it is satisfied or cancelled. Call this outside of interrupt context, e.g. from loop()
+    /// or after onReceive() has triggered, or leave it to a ReadResumer.
+    /// Without received data or a pending read, this returns at once.
+    /// @returns true if a pending read was completed
+    bool resumeReader();
+#ifdef __cpp_impl_coroutine
+    class ReadAwaiter;
+    template<typename Executor> class ReadResumer;
+    /// co_await reading of size bytes into buffer, resuming through resumeReader().
+    /// Only one read can be pending, a second one resolves at once to the bytes it found available.
+    /// @returns An awaitable that resolves to the number of bytes read, which is only less than
+    /// size if ct is cancelled, rx is disabled, or another read is pending.
+    ReadAwaiter readAsync(uint8_t* buffer, size_t size);
+    ReadAwaiter readAsync(uint8_t* buffer, size_t size, ghostl::cancellation_token ct);
+    /// co_await reading into buffer, up to and including the delimiter, or until size bytes are read,
+    /// resuming through resumeReader().
+    /// @returns An awaitable that resolves to the number of bytes read, including the delimiter.
+    ReadAwaiter readUntil(uint8_t* buffer, size_t size, uint8_t delimiter);
+    ReadAwaiter readUntil(uint8_t* buffer, size_t size, uint8_t delimiter, ghostl::cancellation_token ct);
+#endif
+
     using Print::write;
 
 protected:
     void beginRx(bool hasPullUp, int bufCapacity, int isrBufCapacity);
+    /// Set up rx on user-provided buffers instead of allocating them, which must outlive the object.
+    /// parityBuffer must hold a bit for each byte of buffer, and is not used without parity.
+    void beginRx(bool hasPullUp, circular_queue<uint8_t>& buffer, circular_queue<uint8_t>& parityBuffer,
+        circular_queue_pow2<uint32_t, UARTBase*>& isrBuffer);
     void beginTx();
+    /// Backends release their peripherals here, first thing in end().
+    virtual void endBackend() {}
+    /// Backends that generate the tx waveform in hardware send the frames here.
+    /// @returns false to bit-bang the frames on the tx GPIO pin instead.
+    virtual bool writeFrames(const uint8_t* buffer, size_t size, Parity parity) {
+        (void)buffer; (void)size; (void)parity;
+        return false;
+    }
+    /// Store a captured rx edge for decoding.
+    /// @param tick the time of the edge
+    /// @param level the verbatim line level after the edge
+    inline void IRAM_ATTR pushRxEdge(uint32_t tick, bool level) ALWAYS_INLINE_ATTR {
+        // tick's LSB is repurposed for the level bit
+        if (!m_isrBuffer->push((tick | 1U) ^ !level)) isrOverflow();
+        m_rxEdgeTick = tick;
+    }
+    /// Trigger the rx callback, or with frame delivery, the alarm that does once the line is idle.
+    inline void IRAM_ATTR rxWakeup() ALWAYS_INLINE_ATTR {
+        if (m_rxResumer) m_rxResumer();
+        if (m_frameWakeup) m_frameAlarm.arm(ticksToMicros(frameWakeupTicks()));
+        else m_rxHandler();
+    }
+    /// Flag an rx edge that found the ISR buffer full.
+    inline void IRAM_ATTR isrOverflow() ALWAYS_INLINE_ATTR {
+        m_isrOverflow.store(true);
+#ifdef SWSERIAL_STATS
+        ++m_stats.isrOverflows;
+#endif
+    }
+    /// Store the current tick as a captured rx edge, and trigger the rx callback when the receiver was starved.
+    /// @param level the verbatim line level after the edge
+    inline void IRAM_ATTR rxEdge(bool level) ALWAYS_INLINE_ATTR {
+        if (m_rxMuted) return;
+#ifdef SWSERIAL_STATS
+        const uint32_t entry = Hal::cycles();
+#endif
+        const uint32_t curTick = ticks();
+        const bool empty = !m_isrBuffer->available();
+        pushRxEdge(curTick, level);
+        // Trigger rx callback only when receiver is starved
+        if (empty) rxWakeup();
+#ifdef SWSERIAL_STATS
+        UARTStats::count(m_stats.isrCycles, Hal::cycles() - entry, 6);
+#endif
+    }
     // Member variables
     int8_t m_rxPin = -1;
     int8_t m_txPin = -1;
     bool m_invert = false;
+    /// false if a backend owns the rx pin, then enableRx() attaches no GPIO interrupt
+    bool m_rxGPIO = true;
+    /// false if a backend owns the tx pin, then enableAsyncTx() has no effect
+    bool m_txGPIO = true;
+    /// the rx GPIO edge interrupt for bitrates up to 74880bps, which derived classes may specialize
+    void (*m_rxBitISR)(UARTBase*) = rxBitISR;
+    /// The frame geometry as set by begin(), that the rx decoder and the tx writer read at runtime.
+    struct ConfiguredFrame {
+        static inline uint8_t dataBits(const UARTBase& uart) ALWAYS_INLINE_ATTR { return uart.m_dataBits; }
+        static inline bool parity(const UARTBase& uart) ALWAYS_INLINE_ATTR { return uart.m_parityMode; }
+        static inline uint8_t pduBits(const UARTBase& uart) ALWAYS_INLINE_ATTR { return uart.m_pduBits; }
+        static inline bool invert(const UARTBase& uart) ALWAYS_INLINE_ATTR { return uart.m_invert; }
+    };
+    /// A frame geometry fixed at compile time, which folds the rx decoder's and the tx writer's
+    /// loops and branches on it. It must match the config and invert arguments to begin().
+    template< uint8_t DATA_BITS, bool PARITY, uint8_t STOP_BITS, bool INVERT >
+    struct FixedFrame {
+        static_assert(DATA_BITS >= 5 && DATA_BITS <= 8 && STOP_BITS >= 1 && STOP_BITS <= 2, "not a valid frame");
+        static constexpr uint8_t dataBits(const UARTBase&) { return DATA_BITS; }
+        static constexpr bool parity(const UARTBase&) { return PARITY; }
+        static constexpr uint8_t pduBits(const UARTBase&) { return DATA_BITS + PARITY + STOP_BITS; }
+        static constexpr bool invert(const UARTBase&) { return INVERT; }
+    };
+    /// Use the rx decoder and the tx writer instances for Frame.
+    template< class Frame > void useFrame() {
+        m_rxBitsCore = &UARTBase::rxBitsCore<Frame>;
+#if __GNUC__ >= 12
+        m_writeBits = &UARTBase::writeBits<Frame>;
+#else
+        // earlier GCC doesn't honor IRAM_ATTR for the template's implicit instances,
+        // keep the generic writer, which SoftwareSerial.cpp instantiates in IRAM
+#endif
+    }
 
 private:
+#ifdef SWSERIAL_RMT
+    friend class RmtUARTBase;
+#endif
+    friend class UARTDispatcher;
+    friend class UARTMultiWriter;
     // It's legal to exceed the deadline, for instance,
     // by enabling interrupts.
     void lazyDelay();
@@ -320,50 +812,111 @@ private:
     // If withStopBit is set, either cycle contains a stop bit.
     // If dutyCycle == 0, the level is not forced to HIGH.
     // If offCycle == 0, the level remains unchanged from dutyCycle.
-    void writePeriod(
+    template< class Frame > void writePeriod(
         uint32_t dutyCycle, uint32_t offCycle, bool withStopBit);
+    // Bit-bang the frames on the tx GPIO pin, with the interrupts disabled unless m_intTxEnabled
+    template< class Frame > void writeBits(const uint8_t* buffer, size_t size, Parity parity);
+    // @returns The LSB-first start-data-parity-stop bit pattern of byte, inverted if applicable
+    uint32_t txWord(uint8_t byte, Parity parity) const;
+    // @returns The same as txWord(), from the precomputed frames if available for parity
+    template< class Frame = ConfiguredFrame >
+    ALWAYS_INLINE_ATTR inline uint32_t IRAM_ATTR txFrame(uint8_t byte, Parity parity) const {
+        if (m_txFrames && parity == m_parityMode) {
+            return m_txFrames[byte & ((1U << Frame::dataBits(*this)) - 1)];
+        }
+        return txWord(byte, parity);
+    }
+    // @returns The count of bits, up to maxBits, from the LSB of word that have the same level as the LSB
+    static inline uint8_t IRAM_ATTR txRunLength(uint32_t word, uint8_t maxBits) ALWAYS_INLINE_ATTR {
+        const uint32_t changes = (word & 1) ? ~word : word;
+        return changes ? min(static_cast<uint8_t>(__builtin_ctz(changes)), maxBits) : maxBits;
+    }
+    inline void IRAM_ATTR setTxLevel(bool high) ALWAYS_INLINE_ATTR {
+        Hal::writeOutput(m_txReg, m_txPin, m_txBitMask, high);
+    }
+    inline void IRAM_ATTR setTxEnableLevel(bool high) ALWAYS_INLINE_ATTR {
+        Hal::writeOutput(m_txEnableReg, m_txEnablePin, m_txEnableBitMask, high);
+    }
+    // Wait for the inter-frame gap on the rx line before a write in bus mode, then mute rx
+    bool acquireBus();
+    // Complete the pending stop bits, release the transmit enable pin, and unmute rx without interruption
+    void releaseBus();
+    // Kick off the tx ISR unless it is already running
+    void startAsyncTx();
+    // Wait until the tx ISR has sent all queued bytes
+    void drainAsyncTx();
+    // queues on the heap, or in user-provided storage
+    template< typename Q > using QueuePtr = std::unique_ptr<Q, borrowing_deleter<Q> >;
+    // the part of beginRx() after the buffers are in place
+    void setupRx(bool hasPullUp);
+    // the part of enableAsyncTx() after the buffer is in place
+    void setupAsyncTx(QueuePtr<circular_queue<uint8_t> >&& txBuffer);
+    // the part of enableFrames() after the descriptor queue is in place
+    void setupFrames(QueuePtr<circular_queue<RxFrame> >&& frames, uint32_t gapMicros);
     // safely set the pin mode for the Rx GPIO pin
     void setRxGPIOPinMode();
     // safely set the pin mode for the Tx GPIO pin
     void setTxGPIOPinMode();
+    // decoded bytes pending to be pushed into m_buffer at once, with their parity bits
+    struct RxBatch {
+        uint8_t bytes[8];
+        uint8_t parities = 0;
+        uint8_t size = 0;
+    };
     /* check m_rxValid that calling is safe */
-    void rxBits();
-    void rxBits(const uint32_t isrTick);
+    void rxBits() { (this->*m_rxBitsCore)(); }
+    template< class Frame > void rxBitsCore();
+    template< class Frame > void rxBits(const uint32_t isrTick, RxBatch& batch);
+    void rxFlush(RxBatch& batch);
+    void setBitTicksFx(uint32_t bitTicksFx);
+    /// Rescale the bit timing if the CPU frequency has changed since the last call.
+    void syncTimebase();
+    void calibrate(uint32_t ticksDiff, uint32_t bits, bool level);
+    // account the bytes pushed into m_buffer to the current frame
+    void frameBytes(const uint8_t* bytes, size_t pushed, size_t size);
+    void endFrame(uint8_t status);
+    // from the last rx edge until the completion of an idle gap after the frame
+    inline uint32_t IRAM_ATTR frameWakeupTicks() const ALWAYS_INLINE_ATTR {
+        return (m_frameGapBits + m_pduBits + 1) * m_bitTicks;
+    }
+    static void frameAlarmISR(UARTBase* self);
+    // advance the parity bitmap by count popped bytes
+    void popParity(size_t count);
     static void disableInterrupts();
     static void restoreInterrupts();
+    void setRxResumer(Delegate<void(), void*>&& resumer);
 
     static void rxBitISR(UARTBase* self);
     static void rxBitSyncISR(UARTBase* self);
+    static void asyncTxISR(UARTBase* self);
+    static void rxStartBitISR(UARTBase* self);
+    static void rxSampleISR(UARTBase* self);
 
     static inline uint32_t IRAM_ATTR ticks() ALWAYS_INLINE_ATTR {
-#ifdef CCYTICKS
-        return ESP.getCycleCount() << 1;
-#else
-        return micros() << 1;
-#endif // CCYTICKS
+        return Hal::ticks();
     }
     static inline uint32_t IRAM_ATTR microsToTicks(uint32_t micros) ALWAYS_INLINE_ATTR {
-#ifdef CCYTICKS
-        return (ESP.getCpuFreqMHz() * micros) << 1;
+#ifdef CCY_TICKS
+        return (m_cpuFreqMHz * micros) << 1;
 #else
         return micros << 1;
-#endif // CCYTICKS
+#endif // CCY_TICKS
     }
-    static inline uint32_t ticksToMicros(uint32_t ticks) ALWAYS_INLINE_ATTR {
-#ifdef CCYTICKS
-        return (ticks >> 1) / ESP.getCpuFreqMHz();
+    static inline uint32_t IRAM_ATTR ticksToMicros(uint32_t ticks) ALWAYS_INLINE_ATTR {
+#ifdef CCY_TICKS
+        return (ticks >> 1) / m_cpuFreqMHz;
 #else
         return ticks >> 1;
-#endif // CCYTICKS
+#endif // CCY_TICKS
     }
 
     // Member variables
     volatile uint32_t* m_rxReg;
     uint32_t m_rxBitMask;
-#if !defined(ESP8266)
     volatile uint32_t* m_txReg;
-#endif
     uint32_t m_txBitMask;
+    volatile uint32_t* m_txEnableReg;
+    uint32_t m_txEnableBitMask;
     int8_t m_txEnablePin = -1;
     uint8_t m_dataBits;
     bool m_oneWire;
@@ -371,6 +924,10 @@ private:
     bool m_rxEnabled = false;
     bool m_txValid = false;
     bool m_txEnableValid = false;
+    bool m_busMode = false;
+    uint32_t m_busGapMicros = 0;
+    // from acquireBus() to releaseBus(), the rx ISRs skip the echo of the own frames
+    volatile bool m_rxMuted = false;
     /// PDU bits include data, parity and stop bits; the start bit is not counted.
     uint8_t m_pduBits;
     bool m_intTxEnabled;
@@ -382,12 +939,29 @@ private:
     bool m_lastReadParity;
     bool m_overflow = false;
     uint32_t m_bitTicks;
+    // bit duration in 1/256 ticks, the rx decoding rounds by it
+    uint32_t m_bitTicksFx;
+    // fixed-point reciprocal of m_bitTicksFx, accurate to 1/256 bit for dividends up to m_bitTicksRecipLimit
+    uint32_t m_bitTicksRecip;
+    uint32_t m_bitTicksRecipLimit;
+#ifdef CCY_TICKS
+    // the CPU frequency as last read from main context, ISRs convert ticks by it
+    static uint32_t m_cpuFreqMHz;
+#endif
+    // the CPU frequency that m_bitTicksFx is scaled for, 0 before begin()
+    uint32_t m_bitTicksMHz = 0;
+    bool m_calibrate = false;
+    uint16_t m_autoBaudEdges = 0;
+    // the sums of ticks and bits of the edge intervals being averaged, or the shortest during auto baud
+    uint32_t m_calTicks = 0;
+    uint32_t m_calBits = 0;
     uint8_t m_parityInPos;
     uint8_t m_parityOutPos;
     int8_t m_rxLastBit; // 0 thru (m_pduBits - m_stopBits - 1): data/parity bits. -1: start bit. (m_pduBits - 1): stop bit.
     uint8_t m_rxCurByte = 0;
-    std::unique_ptr<circular_queue<uint8_t> > m_buffer;
-    std::unique_ptr<circular_queue<uint8_t> > m_parityBuffer;
+    static constexpr uint8_t BYTE_ALL_BITS_SET = ~static_cast<uint8_t>(0);
+    QueuePtr<circular_queue<uint8_t> > m_buffer;
+    QueuePtr<circular_queue<uint8_t> > m_parityBuffer;
     uint32_t m_periodStart;
     uint32_t m_periodDuration;
 #ifndef ESP32
@@ -396,13 +970,410 @@ private:
     static portMUX_TYPE m_interruptsMux;
 #endif
     // the ISR stores the relative bit times in the buffer. The inversion corrected level is used as sign bit (2's complement):
-    // 1 = positive including 0, 0 = negative.
-    std::unique_ptr<circular_queue<uint32_t, UARTBase*> > m_isrBuffer;
-    const Delegate<void(uint32_t&&), UARTBase*> m_isrBufferForEachDel { [](UARTBase* self, uint32_t&& isrTick) { self->rxBits(isrTick); }, this };
+    // 1 = positive including 0, 0 = negative. Its capacity is a power of two, for masked indexing in the ISRs.
+    QueuePtr<circular_queue_pow2<uint32_t, UARTBase*> > m_isrBuffer;
     std::atomic<bool> m_isrOverflow { false };
     uint32_t m_isrLastTick;
     bool m_rxCurParity = false;
     Delegate<void(), void*> m_rxHandler;
+    // signals the ReadResumer, if any, of new rx data
+    Delegate<void(), void*> m_rxResumer;
+    // the rx decoder and the tx writer, generic or for a FixedFrame
+    void (UARTBase::*m_rxBitsCore)() = &UARTBase::rxBitsCore<ConfiguredFrame>;
+    void (UARTBase::*m_writeBits)(const uint8_t* buffer, size_t size, Parity parity) =
+        &UARTBase::writeBits<ConfiguredFrame>;
+    // frame bit patterns as per txWord() for every data value, with the configured parity
+    // allocated by the first beginTx(), for all data bit counts, and kept across end()
+    std::unique_ptr<uint16_t[]> m_txFrames;
+    QueuePtr<circular_queue<uint8_t> > m_txBuffer;
+    TimerAlarm m_txAlarm;
+    std::atomic<bool> m_txActive { false };
+    // remaining bits of the frame that the tx ISR is sending, LSB next
+    uint32_t m_txWord;
+    uint8_t m_txBitsLeft = 0;
+    uint32_t m_txDeadline;
+    bool m_timerRxEnabled = false;
+    TimerAlarm m_rxAlarm;
+    QueuePtr<circular_queue<RxFrame> > m_frames;
+    TimerAlarm m_frameAlarm;
+    bool m_frameWakeup = false;
+    bool m_frameLengthPrefix = false;
+    int16_t m_frameDelimiter = -1;
+    // the frame gap, and the stop level bits since the end of the last word
+    uint32_t m_frameGapBits = 0;
+    uint32_t m_rxIdleBits = 0;
+    uint32_t m_frameOffset = 0;
+    uint16_t m_frameLength = 0;
+    // the length from the prefix, 0 if none
+    uint16_t m_frameExpected = 0;
+    uint8_t m_frameStatus = 0;
+    bool m_addressFilter = false;
+    // the last address word matched
+    bool m_rxAddressed = false;
+    uint8_t m_address = 0;
+    uint8_t m_addressMask = 0xff;
+    // the tick of the last captured rx edge
+    volatile uint32_t m_rxEdgeTick = 0;
+    // set by rxStartBitISR, rxSampleISR takes over until the stop bit
+    volatile bool m_rxSampling = false;
+    uint8_t m_rxSampleBit;
+    bool m_rxSampleLevel;
+    uint32_t m_rxSampleStart;
+    // if set, the dispatcher's shared ISR captures the rx edges
+    UARTDispatcher* m_dispatcher = nullptr;
+    RxAwaiter* m_rxAwaiter = nullptr;
+#ifdef SWSERIAL_STATS
+    UARTStats m_stats{};
+#endif
+};
+
+#ifdef __cpp_impl_coroutine
+/// The awaitable of UARTBase::readAsync() and UARTBase::readUntil()
+class UARTBase::ReadAwaiter : public UARTBase::RxAwaiter {
+public:
+    ReadAwaiter(UARTBase& uart, uint8_t* buffer, size_t size, int delimiter) :
+        RxAwaiter(buffer, size, delimiter), m_uart(uart) {}
+    ReadAwaiter(UARTBase& uart, uint8_t* buffer, size_t size, int delimiter, ghostl::cancellation_token ct) :
+        RxAwaiter(buffer, size, delimiter), m_uart(uart), m_ct(std::move(ct)), m_cancellable(true) {}
+    ReadAwaiter(const ReadAwaiter&) = delete;
+    ReadAwaiter& operator=(const ReadAwaiter&) = delete;
+    // the awaiting coroutine may be destroyed while suspended
+    ~ReadAwaiter() { m_uart.cancelRx(*this); }
+    bool await_ready() { return m_uart.fillRx(*this); }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        m_handle = handle;
+        // resume at once if another read is pending
+        return m_uart.awaitRx(*this);
+    }
+    size_t await_resume() const { return count; }
+    bool cancelled() const override { return m_cancellable && m_ct.is_cancellation_requested(); }
+    void complete() override { m_handle.resume(); }
+private:
+    UARTBase& m_uart;
+    ghostl::cancellation_token m_ct;
+    bool m_cancellable = false;
+    std::coroutine_handle<> m_handle;
+};
+
+inline UARTBase::ReadAwaiter UARTBase::readAsync(uint8_t* buffer, size_t size) {
+    return ReadAwaiter(*this, buffer, size, -1);
+}
+inline UARTBase::ReadAwaiter UARTBase::readAsync(uint8_t* buffer, size_t size, ghostl::cancellation_token ct) {
+    return ReadAwaiter(*this, buffer, size, -1, std::move(ct));
+}
+inline UARTBase::ReadAwaiter UARTBase::readUntil(uint8_t* buffer, size_t size, uint8_t delimiter) {
+    return ReadAwaiter(*this, buffer, size, delimiter);
+}
+inline UARTBase::ReadAwaiter UARTBase::readUntil(uint8_t* buffer, size_t size, uint8_t delimiter, ghostl::cancellation_token ct) {
+    return ReadAwaiter(*this, buffer, size, delimiter, std::move(ct));
+}
+
+/// Resumes the pending read of a UARTBase from the context of a ghostl::executor<>, driven by the rx wakeups,
+/// instead of by polling resumeReader(). After each wakeup, the received data is decoded on the next run(),
+/// and again once the word in reception has completed. The ReadResumer must outlive the calls to run().
+template<typename Executor>
+class UARTBase::ReadResumer {
+public:
+    ReadResumer(UARTBase& uart, Executor& exec) : m_uart(uart), m_exec(exec), m_event(exec), m_pump(pump()) {
+        // runs up to awaiting the first wakeup
+        m_pump.resume();
+        m_uart.setRxResumer(Delegate<void(), void*>(&ReadResumer::wakeupISR, this));
+    }
+    ReadResumer(const ReadResumer&) = delete;
+    ReadResumer& operator=(const ReadResumer&) = delete;
+    ~ReadResumer() {
+        m_uart.setRxResumer(nullptr);
+    }
+private:
+    static void IRAM_ATTR wakeupISR(void* self) {
+        static_cast<ReadResumer*>(self)->m_event.set();
+    }
+    ghostl::task<> pump() {
+        for (;;) {
+            co_await m_event;
+            if (m_uart.resumeReader()) { continue; }
+            co_await m_exec.delay_us(ticksToMicros((m_uart.m_pduBits + 1) * m_uart.m_bitTicks));
+            m_uart.resumeReader();
+        }
+    }
+    UARTBase& m_uart;
+    Executor& m_exec;
+    typename Executor::event m_event;
+    ghostl::task<> m_pump;
+};
+#endif
+
+// The interrupt guards, and the rx decoder and the tx writer templates, are defined here,
+// such that a FixedUART only instantiates those for its own frame geometry.
+
+ALWAYS_INLINE_ATTR inline void IRAM_ATTR UARTBase::disableInterrupts()
+{
+#ifndef ESP32
+    m_savedPS = xt_rsil(15);
+#else
+    taskENTER_CRITICAL(&m_interruptsMux);
+#endif
+}
+
+ALWAYS_INLINE_ATTR inline void IRAM_ATTR UARTBase::restoreInterrupts()
+{
+#ifndef ESP32
+    xt_wsr_ps(m_savedPS);
+#else
+    taskEXIT_CRITICAL(&m_interruptsMux);
+#endif
+}
+
+template< class Frame >
+ALWAYS_INLINE_ATTR inline void IRAM_ATTR UARTBase::writePeriod(
+    uint32_t dutyCycle, uint32_t offCycle, bool withStopBit) {
+    preciseDelay();
+    if (dutyCycle)
+    {
+        setTxLevel(true);
+        m_periodDuration += dutyCycle;
+        if (offCycle || (withStopBit && !Frame::invert(*this))) {
+            if (!withStopBit || Frame::invert(*this)) {
+                preciseDelay();
+            }
+            else {
+                lazyDelay();
+            }
+        }
+    }
+    if (offCycle)
+    {
+        setTxLevel(false);
+        m_periodDuration += offCycle;
+        if (withStopBit && Frame::invert(*this)) lazyDelay();
+    }
+}
+
+template< class Frame >
+void IRAM_ATTR UARTBase::writeBits(const uint8_t* buffer, size_t size, Parity parity) {
+    // Stop bit: if inverted, LOW, otherwise HIGH
+    bool b = !Frame::invert(*this);
+    uint32_t dutyCycle = 0;
+    uint32_t offCycle = 0;
+    if (!m_intTxEnabled) {
+        // Disable interrupts in order to get a clean transmit timing
+        disableInterrupts();
+    }
+    bool withStopBit = true;
+    m_periodDuration = 0;
+    m_periodStart = ticks();
+    for (size_t cnt = 0; cnt < size; ++cnt) {
+        uint32_t word = txFrame<Frame>(pgm_read_byte(buffer + cnt), parity);
+        // replay the frame as runs of equal level bits
+        for (uint8_t bitsLeft = Frame::pduBits(*this) + 1; bitsLeft;) {
+            const uint8_t bits = txRunLength(word, bitsLeft);
+            word >>= bits;
+            bitsLeft -= bits;
+            bool pb = b;
+            b = !b;
+            if (!pb && b) {
+                writePeriod<Frame>(dutyCycle, offCycle, withStopBit);
+                withStopBit = false;
+                dutyCycle = offCycle = 0;
+            }
+            if (b) {
+                dutyCycle += bits * m_bitTicks;
+            }
+            else {
+                offCycle += bits * m_bitTicks;
+            }
+        }
+        withStopBit = true;
+    }
+    // in bus mode, the stop bits are completed by the turnaround
+    writePeriod<Frame>(dutyCycle, offCycle, !m_busMode);
+    if (m_busMode) {
+        releaseBus();
+    }
+    if (!m_intTxEnabled) {
+        // restore the interrupt state if applicable
+        restoreInterrupts();
+    }
+}
+
+template< class Frame >
+void UARTBase::rxBitsCore() {
+#ifdef ESP8266
+    if (m_isrOverflow.load()) {
+        m_overflow = true;
+        m_isrOverflow.store(false);
+    }
+#else
+    if (m_isrOverflow.exchange(false)) {
+        m_overflow = true;
+    }
+#endif
+
+    RxBatch batch;
+    // one snapshot of the edges for all of the handling, released in one go
+    uint32_t* isrTicks;
+    uint32_t* wrapTicks;
+    size_t size;
+    size_t wrapSize;
+    if (const size_t avail = m_isrBuffer->peek_blocks(isrTicks, size, wrapTicks, wrapSize)) {
+        syncTimebase();
+#ifdef SWSERIAL_STATS
+        m_stats.edges += avail;
+        if (avail > m_stats.isrBufferHighWater) m_stats.isrBufferHighWater = avail;
+#endif
+        for (size_t i = 0; i < size; ++i) {
+            rxBits<Frame>(isrTicks[i], batch);
+        }
+        for (size_t i = 0; i < wrapSize; ++i) {
+            rxBits<Frame>(wrapTicks[i], batch);
+        }
+        m_isrBuffer->pop_n(nullptr, avail);
+    }
+
+    // A stop bit can go undetected if leading data bits are at same level
+    // and there was also no next start bit yet, so one word may be pending.
+    // Check that there was no new ISR data received in the meantime, inserting an
+    // extraneous stop level bit out of sequence breaks rx.
+    if (m_rxLastBit < Frame::pduBits(*this) - 1 && !m_autoBaudEdges) {
+        const uint32_t detectionTicks = (Frame::pduBits(*this) - 1 - m_rxLastBit) * m_bitTicks;
+        if (!m_isrBuffer->available() && ticks() - m_isrLastTick > detectionTicks) {
+            // Produce faux stop bit level, prevents start bit maldetection
+            // tick's LSB is repurposed for the level bit
+            rxBits<Frame>(((m_isrLastTick + detectionTicks) | 1) ^ Frame::invert(*this), batch);
+        }
+    }
+    if (batch.size) rxFlush(batch);
+    // the last frame ends once the line has been idle for the frame gap
+    if (m_frameLength && m_rxLastBit >= Frame::pduBits(*this) - 1 && !m_isrBuffer->available() &&
+        ticks() - m_isrLastTick >= m_frameGapBits * m_bitTicks) {
+        endFrame(FRAME_IDLE);
+    }
+}
+
+template< class Frame >
+void UARTBase::rxBits(const uint32_t isrTick, RxBatch& batch) {
+    const bool level = (m_isrLastTick & 1) ^ Frame::invert(*this);
+
+    // error introduced by edge value in LSB of isrTick is negligible
+    uint32_t ticksDiff = isrTick - m_isrLastTick;
+    m_isrLastTick = isrTick;
+
+    if (m_autoBaudEdges) {
+        if (ticksDiff && ticksDiff < m_calTicks) m_calTicks = ticksDiff;
+        if (--m_autoBaudEdges) return;
+        if (m_calTicks < (UINT32_MAX >> 8)) setBitTicksFx(m_calTicks << 8);
+        // resynchronize on the next start bit
+        m_rxLastBit = Frame::pduBits(*this) - 1;
+        m_rxCurByte = 0;
+        m_rxCurParity = false;
+        enableCalibration(true);
+        return;
+    }
+
+    uint32_t bits;
+    if (ticksDiff < m_bitTicksRecipLimit) {
+        // rounds up if the remainder exceeds half a bit, same as below
+        const uint32_t dividend = ticksDiff + (m_bitTicksFx >> 9);
+        bits = (static_cast<uint64_t>(dividend) * m_bitTicksRecip) >> 32;
+    }
+    else {
+        // long idle periods
+        bits = ((static_cast<uint64_t>(ticksDiff) << 8) + (m_bitTicksFx >> 1)) / m_bitTicksFx;
+    }
+    if (m_calibrate) calibrate(ticksDiff, bits, level);
+    while (bits > 0) {
+        // start bit detection
+        if (m_rxLastBit >= (Frame::pduBits(*this) - 1)) {
+            // leading edge of start bit?
+            if (level) {
+                m_rxIdleBits = (bits < UINT32_MAX - m_rxIdleBits) ? m_rxIdleBits + bits : UINT32_MAX;
+                break;
+            }
+            if (m_frames && m_rxIdleBits >= m_frameGapBits) {
+                // the bytes before the gap complete the frame
+                if (batch.size) rxFlush(batch);
+                if (m_frameLength) endFrame(FRAME_IDLE);
+            }
+            m_rxIdleBits = 0;
+            m_rxLastBit = -1;
+            --bits;
+            continue;
+        }
+        // data bits
+        if (m_rxLastBit < (Frame::dataBits(*this) - 1)) {
+            uint8_t dataBits = min(bits, static_cast<uint32_t>(Frame::dataBits(*this) - 1 - m_rxLastBit));
+            m_rxLastBit += dataBits;
+            bits -= dataBits;
+            m_rxCurByte >>= dataBits;
+            if (level) { m_rxCurByte |= (BYTE_ALL_BITS_SET << (8 - dataBits)); }
+            continue;
+        }
+        // parity bit
+        if (Frame::parity(*this) && m_rxLastBit == (Frame::dataBits(*this) - 1)) {
+            ++m_rxLastBit;
+            --bits;
+            m_rxCurParity = level;
+            continue;
+        }
+        // stop bits
+        // Queue the received value for storing in the buffer
+        // if not high stop bit level, discard word
+        const uint32_t stopBits = Frame::pduBits(*this) - 1 - m_rxLastBit;
+        m_rxIdleBits = (level && bits > stopBits) ? bits - stopBits : 0;
+        if (bits >= stopBits && level) {
+            m_rxCurByte >>= (sizeof(uint8_t) * 8 - Frame::dataBits(*this));
+            if (m_addressFilter) {
+                // the 9th bit marks address words, the data words follow the matching one
+                if (m_rxCurParity) m_rxAddressed = !((m_rxCurByte ^ m_address) & m_addressMask);
+            }
+#ifdef SWSERIAL_STATS
+            if (m_addressFilter) {
+                if (!m_rxAddressed) ++m_stats.filteredWords;
+            }
+            else if (Frame::parity(*this)) {
+                const bool parity =
+                    (m_parityMode == PARITY_EVEN) ? parityEven(m_rxCurByte) :
+                    (m_parityMode == PARITY_ODD) ? parityOdd(m_rxCurByte) :
+                    (m_parityMode == PARITY_MARK);
+                if (parity != m_rxCurParity) ++m_stats.parityErrors;
+            }
+#endif
+            if (!m_addressFilter || m_rxAddressed) {
+                batch.parities |= static_cast<uint8_t>(m_rxCurParity) << batch.size;
+                batch.bytes[batch.size++] = m_rxCurByte;
+                if (batch.size == sizeof(batch.bytes)) rxFlush(batch);
+            }
+        }
+        else {
+#ifdef SWSERIAL_STATS
+            ++m_stats.framingErrors;
+#endif
+            m_frameStatus |= FRAME_ERROR;
+        }
+        m_rxLastBit = Frame::pduBits(*this) - 1;
+        // reset to 0 is important for masked bit logic
+        m_rxCurByte = 0;
+        m_rxCurParity = false;
+        break;
+    }
+}
+
+/// @returns the least power of two that is not less than n
+constexpr size_t roundUpPow2(size_t n, size_t pow2 = 1) {
+    return pow2 >= n ? pow2 : roundUpPow2(n, pow2 << 1);
+}
+
+/// Statically sized storage for the rx buffers of a BasicUART, for use instead of
+/// buffers on the heap. The storage must outlive the BasicUART object.
+/// @param bufCapacity the capacity for the received bytes buffer
+/// @param isrBufCapacity the capacity of the internal asynchronous bit receive buffer, a suggested
+///        size is bufCapacity times the sum of start, data, parity and stop bit count.
+///        It is rounded up to a power of two.
+template< size_t bufCapacity, size_t isrBufCapacity = bufCapacity * 10 >
+struct RxStorage {
+    circular_queue_static<uint8_t, bufCapacity> buffer;
+    circular_queue_static<uint8_t, (bufCapacity + 7) / 8> parityBuffer;
+    circular_queue_static<uint32_t, roundUpPow2(isrBufCapacity), UARTBase*, true> isrBuffer;
 };
 
 template< class GpioCapabilities > class BasicUART : public UARTBase {
@@ -427,13 +1398,33 @@ public:
     /// @param bufCapacity the capacity for the received bytes buffer
     /// @param isrBufCapacity 0: derived from bufCapacity. The capacity of the internal asynchronous
     ///        bit receive buffer, a suggested size is bufCapacity times the sum of
-    ///        start, data, parity and stop bit count.
+    ///        start, data, parity and stop bit count. It is rounded up to a power of two.
     void begin(uint32_t baud, Config config,
         int8_t rxPin, int8_t txPin, bool invert,
         int bufCapacity = 64, int isrBufCapacity = 0) {
         UARTBase::begin(baud, config, rxPin, txPin, invert);
         if (GpioCapabilities::isValidInputPin(rxPin)) {
-            beginRx(GpioCapabilities:: hasPullUp(rxPin), bufCapacity, isrBufCapacity);
+            beginRx(GpioCapabilities::hasPullUp(rxPin), bufCapacity, isrBufCapacity);
+        }
+        if (GpioCapabilities::isValidOutputPin(txPin)) {
+            beginTx();
+        }
+        enableRx(true);
+    }
+    /// Configure the BasicUART object for use, without allocating the rx buffers on the heap.
+    /// @param baud the TX/RX bitrate
+    /// @param config sets databits, parity, and stop bit count
+    /// @param rxPin -1 or default: either no RX pin, or keeps the rxPin set in the ctor
+    /// @param txPin -1 or default: either no TX pin (onewire), or keeps the txPin set in the ctor
+    /// @param invert true: uses invert line level logic
+    /// @param rxStorage the rx buffers, any previous contents are discarded
+    template< size_t bufCapacity, size_t isrBufCapacity >
+    void begin(uint32_t baud, Config config,
+        int8_t rxPin, int8_t txPin, bool invert,
+        RxStorage<bufCapacity, isrBufCapacity>& rxStorage) {
+        UARTBase::begin(baud, config, rxPin, txPin, invert);
+        if (GpioCapabilities::isValidInputPin(rxPin)) {
+            beginRx(GpioCapabilities::hasPullUp(rxPin), rxStorage.buffer, rxStorage.parityBuffer, rxStorage.isrBuffer);
         }
         if (GpioCapabilities::isValidOutputPin(txPin)) {
             beginTx();
@@ -459,6 +1450,227 @@ public:
 
 using UART = BasicUART< GpioCapabilities >;
 
+/// BasicUART with the pins, the frame format and the bitrate fixed at compile time.
+/// The frame geometry is available as constants and checked by the compiler. The rx decoder
+/// and the tx writer are instantiated for it, and the rx GPIO interrupt accesses the rx pin's
+/// input register and bitmask as constants.
+template< int8_t rxPin, int8_t txPin, Config config, uint32_t baud, bool invert = false,
+    class GpioCapabilities = EspSoftwareSerial::GpioCapabilities >
+class FixedUART : public BasicUART< GpioCapabilities > {
+    static_assert(rxPin >= -1 && txPin >= -1, "pin numbers must be -1 or GPIO pins");
+    static_assert(-1 != rxPin || -1 != txPin, "neither an rx nor a tx pin is given");
+    static_assert(!(config & ~0277), "not a valid Config");
+    static_assert((config & 070) != 010, "not a valid Parity");
+    static_assert(baud > 0, "bitrate must be positive");
+public:
+    static constexpr uint8_t DATA_BITS = 5 + (config & 07);
+    static constexpr Parity PARITY = static_cast<Parity>(config & 070);
+    static constexpr uint8_t STOP_BITS = 1 + ((config & 0300) ? 1 : 0);
+    /// start, data, parity and stop bits
+    static constexpr uint8_t FRAME_BITS = 1 + DATA_BITS + (PARITY != PARITY_NONE) + STOP_BITS;
+
+    FixedUART() : BasicUART< GpioCapabilities >(rxPin, txPin, invert) {
+        this->template useFrame< UARTBase::FixedFrame<DATA_BITS, PARITY != PARITY_NONE, STOP_BITS, invert> >();
+#if __GNUC__ >= 12
+        // earlier GCC doesn't honor IRAM_ATTR for the template's ISR, keep the generic one
+        this->m_rxBitISR = rxBitISR;
+#endif
+    }
+
+    /// Configure the FixedUART object for use.
+    /// @param bufCapacity the capacity for the received bytes buffer
+    /// @param isrBufCapacity 0: derived from bufCapacity. The capacity of the internal asynchronous
+    ///        bit receive buffer, a suggested size is bufCapacity times FRAME_BITS.
+    ///        It is rounded up to a power of two.
+    void begin(int bufCapacity = 64, int isrBufCapacity = 0) {
+        BasicUART< GpioCapabilities >::begin(baud, config, rxPin, txPin, invert, bufCapacity, isrBufCapacity);
+    }
+
+private:
+    static void IRAM_ATTR rxBitISR(UARTBase* self) {
+        static_cast<FixedUART*>(self)->rxEdge(*Hal::inputRegister(rxPin) & Hal::bitMask(rxPin));
+    }
+};
+
+/// Services the rx GPIO interrupts of several UARTBase instances from a single ISR.
+/// Per interrupt, the GPIO input register and the tick are read only once, and compared
+/// against the previous pin levels. Every registered instance whose rx pin has changed
+/// gets an edge recorded, including coinciding edges on pins whose own interrupt is still pending.
+/// Only bitrates up to 74880bps, that use the rx edge interrupt, are supported, and
+/// all rx pins must be on the same GPIO input register.
+class UARTDispatcher {
+public:
+    static constexpr size_t MAX_PORTS = 8;
+    UARTDispatcher() = default;
+    UARTDispatcher(const UARTDispatcher&) = delete;
+    UARTDispatcher& operator= (const UARTDispatcher&) = delete;
+    ~UARTDispatcher();
+    /// Register a UARTBase instance, after its begin(), to have its rx edges captured by the shared ISR.
+    /// @returns false if the instance has no valid rx pin, its bitrate is too high,
+    ///          or its pin is on another GPIO input register, or MAX_PORTS are registered already.
+    bool add(UARTBase& port);
+    /// Return the UARTBase instance to its own rx interrupt. This happens implicitly on its end().
+    void remove(UARTBase& port);
+    /// onReceive sets a callback that will be called in interrupt context
+    /// when any of the registered instances has detected a new reception,
+    /// after the onReceive callbacks of the individual instances.
+    /// All instances can then be serviced in one pass, the same
+    /// reservations about reading as for UARTBase::onReceive() apply.
+    void onReceive(const Delegate<void(), void*>& handler);
+    /// onReceive sets a callback that will be called in interrupt context
+    /// when any of the registered instances has detected a new reception,
+    /// after the onReceive callbacks of the individual instances.
+    /// All instances can then be serviced in one pass, the same
+    /// reservations about reading as for UARTBase::onReceive() apply.
+    void onReceive(Delegate<void(), void*>&& handler);
+
+private:
+    friend class UARTBase;
+    // attach or detach the shared ISR for the rx pin of port
+    void enableRx(UARTBase& port, bool on);
+    static void rxEdgesISR(UARTDispatcher* self);
+
+    UARTBase* m_ports[MAX_PORTS];
+    size_t m_portCount = 0;
+    volatile uint32_t* m_rxReg = nullptr;
+    // the rx pins that have the shared ISR attached
+    uint32_t m_rxBitMasks = 0;
+    // the pin levels as at the previous interrupt
+    uint32_t m_levels = 0;
+    Delegate<void(), void*> m_rxHandler;
+};
+
+/// Sends on the tx pins of several UARTBase instances in parallel, from a single timing loop.
+/// All instances must have the same bitrate and frame length, and their tx pins must be on the
+/// same GPIO output register. The frames of all instances are sent in lockstep, and per bit, all
+/// pins are driven by one masked register write for the high and one for the low levels.
+/// Broadcasting to several devices thus takes as long as writing to one of them.
+/// Interrupts are disabled during each frame unless the first instance has enableIntTx(true),
+/// the transmit enable pins are asserted for the duration of a write, bus mode has no effect.
+class UARTMultiWriter {
+public:
+    static constexpr size_t MAX_PORTS = 8;
+    UARTMultiWriter() = default;
+    UARTMultiWriter(const UARTMultiWriter&) = delete;
+    UARTMultiWriter& operator= (const UARTMultiWriter&) = delete;
+    /// Register a UARTBase instance, after its begin(), for the parallel writes.
+    /// @returns false if the instance has no valid tx GPIO pin or is in one-wire mode,
+    ///          its bitrate or frame length differs from the instances registered before,
+    ///          its pin is on another GPIO output register, or MAX_PORTS are registered already.
+    bool add(UARTBase& port);
+    /// Unregister a UARTBase instance. This must happen before its end().
+    void remove(UARTBase& port);
+    /// Send the same data on all registered instances at once.
+    /// @returns the number of bytes written to each instance.
+    size_t write(const uint8_t* buffer, size_t size);
+    /// Send buffers[i] of sizes[i] bytes on the i-th registered instance, in the order of
+    /// registration, all starting at once. The lines of shorter data remain at the stop level.
+    /// @returns the number of bytes of the longest data.
+    size_t write(const uint8_t* const buffers[], const size_t sizes[]);
+
+private:
+    UARTBase* m_ports[MAX_PORTS];
+    size_t m_portCount = 0;
+    // the tx pins of all registered instances
+    uint32_t m_txBitMasks = 0;
+};
+
+#ifdef SWSERIAL_RMT
+/// UARTBase backend on the RMT peripheral of the ESP32 family.
+/// The RMT channels capture and generate the line waveform in hardware, so there
+/// are no GPIO edge interrupts. Each rx capture ends once the line has been idle for
+/// the duration of one frame, and a burst must fit into the RMT receive memory, or its
+/// edges are discarded as an overflow.
+/// Only two-wire operation is supported, and enableAsyncTx() or enableTimerRx() have no effect.
+class RmtUARTBase : public UARTBase {
+public:
+    using UARTBase::UARTBase;
+    ~RmtUARTBase() override;
+
+protected:
+    void beginRmtRx(rmt_reserve_memsize_t memsize);
+    void beginRmtTx();
+    void endBackend() override;
+    bool writeFrames(const uint8_t* buffer, size_t size, Parity parity) override;
+
+private:
+    // RMT tick rate, yields 0.5us, which is also the UARTBase tick in micros mode
+    static constexpr uint32_t RMT_FREQUENCY = 2000000UL;
+    static constexpr uint32_t RMT_MAX_DURATION = 0x7fff;
+    // pulses shorter than this are filtered as glitches
+    static constexpr uint32_t RMT_GLITCH_NS = 100;
+    static constexpr size_t RMT_TX_SYMBOLS = 32;
+    /// Converts a completed capture into edges, and re-arms the receiver at once.
+    static bool rmtRxDoneISR(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t* event, void* self);
+    bool restartRmtRx();
+    rmt_channel_handle_t m_rmtRxChannel = nullptr;
+    rmt_receive_config_t m_rmtRxConfig{};
+    bool m_rmtTx = false;
+    // UARTBase ticks per RMT tick
+    uint32_t m_rmtTickTicks;
+    uint32_t m_rmtIdleTicks;
+    std::unique_ptr<rmt_symbol_word_t[]> m_rmtRxSymbols;
+    size_t m_rmtRxCapacity = 0;
+};
+
+template< class GpioCapabilities > class BasicRmtUART : public RmtUARTBase {
+    static_assert(std::is_base_of<IGpioCapabilities, GpioCapabilities>::value,
+        "template argument is not derived from IGpioCapabilities");
+public:
+    BasicRmtUART() : RmtUARTBase() {
+    }
+    /// Ctor to set defaults for pins.
+    /// @param rxPin the GPIO pin used for RX
+    /// @param txPin the GPIO pin used for TX
+    BasicRmtUART(int8_t rxPin, int8_t txPin = -1, bool invert = false) :
+        RmtUARTBase(rxPin, txPin, invert) {
+    }
+
+    /// Configure the BasicRmtUART object for use.
+    /// @param baud the TX/RX bitrate
+    /// @param config sets databits, parity, and stop bit count
+    /// @param rxPin -1 or default: either no RX pin, or keeps the rxPin set in the ctor
+    /// @param txPin -1 or default: either no TX pin, or keeps the txPin set in the ctor
+    /// @param invert true: uses invert line level logic
+    /// @param bufCapacity the capacity for the received bytes buffer
+    /// @param isrBufCapacity 0: derived from bufCapacity. The capacity of the internal
+    ///        edge buffer that the RMT captures are decoded from.
+    /// @param rmtMemsize the RMT memory blocks for rx, limits the edges per burst
+    void begin(uint32_t baud, Config config,
+        int8_t rxPin, int8_t txPin, bool invert,
+        int bufCapacity = 64, int isrBufCapacity = 0,
+        rmt_reserve_memsize_t rmtMemsize = RMT_MEM_NUM_BLOCKS_1) {
+        UARTBase::begin(baud, config, rxPin, txPin, invert);
+        if (GpioCapabilities::isValidInputPin(rxPin)) {
+            beginRx(GpioCapabilities::hasPullUp(rxPin), bufCapacity, isrBufCapacity);
+            beginRmtRx(rmtMemsize);
+        }
+        if (GpioCapabilities::isValidOutputPin(txPin) && m_rxPin != m_txPin) {
+            beginTx();
+            beginRmtTx();
+        }
+        enableRx(true);
+    }
+    void begin(uint32_t baud, Config config,
+        int8_t rxPin, int8_t txPin) {
+        begin(baud, config, rxPin, txPin, m_invert);
+    }
+    void begin(uint32_t baud, Config config,
+        int8_t rxPin) {
+        begin(baud, config, rxPin, m_txPin, m_invert);
+    }
+    void begin(uint32_t baud, Config config = SWSERIAL_8N1) {
+        begin(baud, config, m_rxPin, m_txPin, m_invert);
+    }
+    void setTransmitEnablePin(int8_t txEnablePin) {
+        UARTBase::setTransmitEnablePin(
+            GpioCapabilities::isValidOutputPin(txEnablePin) ? txEnablePin : -1);
+    }
+};
+
+using RmtUART = BasicRmtUART< GpioCapabilities >;
+#endif // SWSERIAL_RMT
+
 }; // namespace EspSoftwareSerial
 
 using SoftwareSerial = EspSoftwareSerial::UART;
@@ -468,13 +1680,18 @@ using namespace EspSoftwareSerial;
 // The template member functions below must be in IRAM, but due to a bug GCC doesn't currently
 // honor the attribute. Instead, it is possible to do explicit specialization and adorn
 // these with the IRAM attribute:
-// Delegate<>::operator (), circular_queue<>::available,
-// circular_queue<>::available_for_push, circular_queue<>::push_peek, circular_queue<>::push
+// Delegate<>::operator (), UARTBase::writeBits<>, circular_queue<>::available,
+// circular_queue<>::available_for_push, circular_queue<>::push_peek, circular_queue<>::push,
+// circular_queue<>::pop
 
 extern template void delegate::detail::DelegateImpl<void*, void>::operator()() const;
-extern template size_t circular_queue<uint32_t, EspSoftwareSerial::UARTBase*>::available() const;
-extern template bool circular_queue<uint32_t, EspSoftwareSerial::UARTBase*>::push(uint32_t&&);
-extern template bool circular_queue<uint32_t, EspSoftwareSerial::UARTBase*>::push(const uint32_t&);
+extern template void EspSoftwareSerial::UARTBase::writeBits<EspSoftwareSerial::UARTBase::ConfiguredFrame>(
+    const uint8_t*, size_t, EspSoftwareSerial::Parity);
+extern template size_t circular_queue<uint32_t, EspSoftwareSerial::UARTBase*, true>::available() const;
+extern template size_t circular_queue<uint8_t>::available() const;
+extern template uint8_t circular_queue<uint8_t>::pop();
+extern template bool circular_queue<uint32_t, EspSoftwareSerial::UARTBase*, true>::push(uint32_t&&);
+extern template bool circular_queue<uint32_t, EspSoftwareSerial::UARTBase*, true>::push(const uint32_t&);
 #endif // __GNUC__ < 12
 
 #endif // __SoftwareSerial_h
@@ -0,0 +1,142 @@
+/*
+SoftwareSerialSim.h - Simulated GPIO and time base backend of EspSoftwareSerial, for host builds.
+Copyright (c) 2023 Dirk O. Kaar. All rights reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __SoftwareSerialSim_h
+#define __SoftwareSerialSim_h
+
+// Included by SoftwareSerial.h if SWSERIAL_SIM is defined, for all translation units alike.
+
+namespace EspSoftwareSerial {
+
+/// Hal backend of a simulated time base and GPIOs, running the UARTs on a host.
+/// Simulated time passes only by advance() and delay(), and by each call of ticks(),
+/// which costs tickCost nanoseconds, such that the busy-waits of the bit timing terminate.
+/// An output pin drives the input pins that are connected to it, and each level change
+/// invokes the interrupt handler attached to the input pin at once, in the writer's context.
+/// This feeds the rx GPIO edge interrupt, for bitrates up to 74880bps, and the UARTDispatcher.
+/// The synchronous rx interrupt of higher bitrates, timer rx, and async tx are not simulated.
+class SimHal : private IHal {
+public:
+    static constexpr int8_t PINS = 32;
+    static constexpr uint32_t CPU_MHZ = 80;
+
+    static inline uint32_t ticks() {
+        s_nanos += s_tickCost;
+        return static_cast<uint32_t>(s_nanos / 1000) << 1;
+    }
+    static inline uint32_t cycles() {
+        return static_cast<uint32_t>(s_nanos * CPU_MHZ / 1000);
+    }
+    static inline uint32_t millis() {
+        return static_cast<uint32_t>(s_nanos / 1000000);
+    }
+    static inline void delay(uint32_t ms) {
+        advance(ms * 1000000ULL);
+    }
+    static inline void optimisticYield(uint32_t intervalMicros) {
+        (void)intervalMicros;
+    }
+    static inline void pinMode(int8_t pin, uint8_t mode) {
+        (void)pin; (void)mode;
+    }
+    static inline void digitalWrite(int8_t pin, bool high) {
+        setLevel(pin, high);
+    }
+    static inline volatile uint32_t* inputRegister(int8_t pin) {
+        (void)pin;
+        return &s_levels;
+    }
+    static inline volatile uint32_t* outputRegister(int8_t pin) {
+        (void)pin;
+        return &s_levels;
+    }
+    static inline uint32_t bitMask(int8_t pin) {
+        return 1UL << pin;
+    }
+    static inline void writeOutput(volatile uint32_t* reg, int8_t pin, uint32_t bitMask, bool high) {
+        (void)reg; (void)bitMask;
+        setLevel(pin, high);
+    }
+    static inline void writeOutputs(int8_t pin, uint32_t setMask, uint32_t clearMask) {
+        (void)pin;
+        for (; setMask; setMask &= setMask - 1) setLevel(__builtin_ctz(setMask), true);
+        for (; clearMask; clearMask &= clearMask - 1) setLevel(__builtin_ctz(clearMask), false);
+    }
+    static inline void attachInterrupt(int8_t pin, void (*isr)(void*), void* arg, int mode) {
+        s_interrupts[pin] = { isr, arg, mode };
+    }
+    static inline void detachInterrupt(int8_t pin) {
+        s_interrupts[pin] = {};
+    }
+
+    /// Wire the output pin from to the input pin to, like the tx pin of one UART to the rx pin of another.
+    static void connect(int8_t from, int8_t to) {
+        s_wires[from] |= 1UL << to;
+    }
+    /// Remove all wiring and interrupt handlers, set all pins high, and restart the time at 0.
+    static void reset() {
+        for (auto& wires : s_wires) wires = 0;
+        for (auto& interrupt : s_interrupts) interrupt = {};
+        s_levels = ~0U;
+        s_nanos = 0;
+    }
+    /// Set the simulated time spent by each call of ticks().
+    static void setTickCost(uint32_t nanos) {
+        s_tickCost = nanos;
+    }
+    /// Let simulated time pass.
+    static void advance(uint64_t nanos) {
+        s_nanos += nanos;
+    }
+    /// @returns the simulated time since the start or reset().
+    static uint64_t nanos() {
+        return s_nanos;
+    }
+    /// Drive pin, and the input pins connected to it, to the level, invoking the interrupt handlers
+    /// of the pins whose level changes.
+    static void setLevel(int8_t pin, bool high) {
+        const uint32_t pins = (1UL << pin) | s_wires[pin];
+        uint32_t changed = (high ? ~s_levels : s_levels) & pins;
+        s_levels = high ? (s_levels | changed) : (s_levels & ~changed);
+        while (changed) {
+            const int p = __builtin_ctz(changed);
+            changed &= changed - 1;
+            const auto& interrupt = s_interrupts[p];
+            if (interrupt.isr && (CHANGE == interrupt.mode || (high ? RISING : FALLING) == interrupt.mode)) {
+                interrupt.isr(interrupt.arg);
+            }
+        }
+    }
+
+private:
+    struct Interrupt {
+        void (*isr)(void*);
+        void* arg;
+        int mode;
+    };
+    static inline volatile uint32_t s_levels = ~0U;
+    static inline uint32_t s_wires[PINS] = {};
+    static inline Interrupt s_interrupts[PINS] = {};
+    static inline uint64_t s_nanos = 0;
+    static inline uint32_t s_tickCost = 20;
+};
+
+}; // namespace EspSoftwareSerial
+
+#endif // __SoftwareSerialSim_h
@@ -50,7 +50,7 @@ namespace
     ALWAYS_INLINE_ATTR inline R IRAM_ATTR vPtrToFunPtrExec(void* fn, P... args)
     {
         using target_type = R(P...);
-        return reinterpret_cast<target_type*>(fn)(std::forward<P...>(args...));
+        return reinterpret_cast<target_type*>(fn)(std::forward<P>(args)...);
     }
 
 }
@@ -281,7 +281,7 @@ namespace delegate
             {
                 return static_cast<DelegatePImpl*>(self)->fnA(
                     static_cast<DelegatePImpl*>(self)->obj,
-                    std::forward<P...>(args...));
+                    std::forward<P>(args)...);
             };
 
             operator FunVPPtr() const
@@ -298,7 +298,7 @@ namespace delegate
                 {
                     return [](void* self, P... args) -> R
                     {
-                        return static_cast<DelegatePImpl*>(self)->functional(std::forward<P...>(args...));
+                        return static_cast<DelegatePImpl*>(self)->functional(std::forward<P>(args)...);
                     };
                 }
             }
@@ -323,7 +323,7 @@ namespace delegate
                 }
                 else if (FPA == kind)
                 {
-                    return [this](P... args) { return fnA(obj, std::forward<P...>(args...)); };
+                    return [this](P... args) { return fnA(obj, std::forward<P>(args)...); };
                 }
                 else
                 {
@@ -343,15 +343,15 @@ namespace delegate
             {
                 if (FP == kind)
                 {
-                    if (fn) return fn(std::forward<P...>(args...));
+                    if (fn) return fn(std::forward<P>(args)...);
                 }
                 else if (FPA == kind)
                 {
-                    if (fnA) return fnA(obj, std::forward<P...>(args...));
+                    if (fnA) return fnA(obj, std::forward<P>(args)...);
                 }
                 else
                 {
-                    if (functional) return functional(std::forward<P...>(args...));
+                    if (functional) return functional(std::forward<P>(args)...);
                 }
                 return R();
             }
@@ -527,7 +527,7 @@ namespace delegate
             {
                 return static_cast<DelegatePImpl*>(self)->fnA(
                     static_cast<DelegatePImpl*>(self)->obj,
-                    std::forward<P...>(args...));
+                    std::forward<P>(args)...);
             };
 
             operator FunVPPtr() const
@@ -566,11 +566,11 @@ namespace delegate
             {
                 if (FP == kind)
                 {
-                    if (fn) return fn(std::forward<P...>(args...));
+                    if (fn) return fn(std::forward<P>(args)...);
                 }
                 else
                 {
-                    if (fnA) return fnA(obj, std::forward<P...>(args...));
+                    if (fnA) return fnA(obj, std::forward<P>(args)...);
                 }
                 return R();
             }
@@ -741,7 +741,7 @@ namespace delegate
                 {
                     return [](void* self, P... args) -> R
                     {
-                        return static_cast<DelegatePImpl*>(self)->functional(std::forward<P...>(args...));
+                        return static_cast<DelegatePImpl*>(self)->functional(std::forward<P>(args)...);
                     };
                 }
             }
@@ -782,11 +782,11 @@ namespace delegate
             {
                 if (FP == kind)
                 {
-                    if (fn) return fn(std::forward<P...>(args...));
+                    if (fn) return fn(std::forward<P>(args)...);
                 }
                 else
                 {
-                    if (functional) return functional(std::forward<P...>(args...));
+                    if (functional) return functional(std::forward<P>(args)...);
                 }
                 return R();
             }
@@ -888,7 +888,7 @@ namespace delegate
             /// on the Xtensa ISA.
             inline R IRAM_ATTR operator()(P... args) const ALWAYS_INLINE_ATTR
             {
-                if (fn) return fn(std::forward<P...>(args...));
+                if (fn) return fn(std::forward<P>(args)...);
                 return R();
             }
 
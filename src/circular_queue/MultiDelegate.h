@@ -23,8 +23,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define __MULTIDELEGATE_H
 
 #include <iterator>
+#include <new>
 #if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
 #include <atomic>
+#include <memory>
 #else
 #include "ghostl.h"
 #endif
@@ -54,7 +56,7 @@ namespace
     {
         static R execute(Delegate& del, P... args)
         {
-            return del(std::forward<P...>(args...));
+            return del(std::forward<P>(args)...);
         }
     };
 
@@ -63,7 +65,7 @@ namespace
     {
         static bool execute(Delegate& del, P... args)
         {
-            del(std::forward<P...>(args...));
+            del(std::forward<P>(args)...);
             return true;
         }
     };
@@ -91,10 +93,41 @@ namespace
 
 namespace delegate
 {
+    /// The default allocator of MultiDelegate items, from the heap.
+    /// On the ESP MCUs, allocation failure returns nullptr instead of throwing.
+    template< typename T >
+    struct heap_allocator
+    {
+        using value_type = T;
+
+        heap_allocator() = default;
+        template< typename U >
+        constexpr heap_allocator(const heap_allocator<U>&) noexcept {}
+
+        T* allocate(size_t n)
+        {
+#if defined(ESP8266) || defined(ESP32)
+            return static_cast<T*>(::operator new(n * sizeof(T), std::nothrow));
+#else
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+#endif
+        }
+        void deallocate(T* p, size_t)
+        {
+            ::operator delete(p);
+        }
+
+        template< typename U >
+        bool operator==(const heap_allocator<U>&) const { return true; }
+        template< typename U >
+        bool operator!=(const heap_allocator<U>&) const { return false; }
+    };
+
     namespace detail
     {
 
-        template< typename Delegate, typename R, bool ISQUEUE = false, size_t QUEUE_CAPACITY = 32, typename... P>
+        template< typename Delegate, typename R, bool ISQUEUE = false, size_t QUEUE_CAPACITY = 32,
+            typename Allocator = heap_allocator<Delegate>, typename... P>
         class MultiDelegatePImpl
         {
         public:
@@ -109,6 +142,8 @@ namespace delegate
 
             MultiDelegatePImpl(MultiDelegatePImpl&& md)
             {
+                static_assert(std::allocator_traits<NodeAllocator>::is_always_equal::value,
+                    "moving requires an allocator without per-instance storage");
                 first = md.first;
                 last = md.last;
                 unused = md.unused;
@@ -131,6 +166,8 @@ namespace delegate
 
             MultiDelegatePImpl& operator=(MultiDelegatePImpl&& md)
             {
+                static_assert(std::allocator_traits<NodeAllocator>::is_always_equal::value,
+                    "moving requires an allocator without per-instance storage");
                 first = md.first;
                 last = md.last;
                 unused = md.unused;
@@ -152,7 +189,7 @@ namespace delegate
                 {
                     auto to_delete = unused;
                     unused = unused->mNext;
-                    delete(to_delete);
+                    delete_node(to_delete);
                 }
                 return *this;
             }
@@ -180,10 +217,28 @@ namespace delegate
                 Delegate mDelegate;
             };
 
+            using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node_t>;
+            using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+
             Node_t* first = nullptr;
             Node_t* last = nullptr;
             Node_t* unused = nullptr;
             size_t nodeCount = 0;
+            NodeAllocator nodeAllocator;
+
+            Node_t* IRAM_ATTR new_node()
+            {
+                Node_t* node = NodeAllocatorTraits::allocate(nodeAllocator, 1);
+                if (node)
+                    NodeAllocatorTraits::construct(nodeAllocator, node);
+                return node;
+            }
+
+            void delete_node(Node_t* node)
+            {
+                NodeAllocatorTraits::destroy(nodeAllocator, node);
+                NodeAllocatorTraits::deallocate(nodeAllocator, node, 1);
+            }
 
             // Returns a pointer to an unused Node_t,
             // or if none are available allocates a new one,
@@ -200,11 +255,7 @@ namespace delegate
                 // if no unused items, and count not too high, allocate a new one
                 else if (nodeCount < QUEUE_CAPACITY)
                 {
-#if defined(ESP8266) || defined(ESP32)
-                    result = new (std::nothrow) Node_t;
-#else
-                    result = new Node_t;
-#endif
+                    result = new_node();
                     if (result)
                         ++nodeCount;
                 }
@@ -222,9 +273,15 @@ namespace delegate
             std::mutex mutex_unused;
 #endif
         public:
-            class iterator : public std::iterator<std::forward_iterator_tag, Delegate>
+            class iterator
             {
             public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = Delegate;
+                using difference_type = std::ptrdiff_t;
+                using pointer = Delegate*;
+                using reference = Delegate&;
+
                 Node_t* current = nullptr;
                 Node_t* prev = nullptr;
                 const Node_t* stop = nullptr;
@@ -298,12 +355,7 @@ namespace delegate
                 std::lock_guard<std::mutex> lock(mutex_unused);
 #endif
 
-                Node_t* item = ISQUEUE ? get_node_unsafe() :
-#if defined(ESP8266) || defined(ESP32)
-                    new (std::nothrow) Node_t;
-#else
-                    new Node_t;
-#endif
+                Node_t* item = ISQUEUE ? get_node_unsafe() : new_node();
                 if (!item)
                     return nullptr;
 
@@ -344,7 +396,7 @@ namespace delegate
                 if (ISQUEUE)
                     recycle_node_unsafe(to_recycle);
                 else
-                    delete to_recycle;
+                    delete_node(to_recycle);
                 return it;
             }
 
@@ -402,11 +454,12 @@ namespace delegate
             }
         };
 
-        template< typename Delegate, typename R = void, bool ISQUEUE = false, size_t QUEUE_CAPACITY = 32>
-        class MultiDelegateImpl : public MultiDelegatePImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY>
+        template< typename Delegate, typename R = void, bool ISQUEUE = false, size_t QUEUE_CAPACITY = 32,
+            typename Allocator = heap_allocator<Delegate>>
+        class MultiDelegateImpl : public MultiDelegatePImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY, Allocator>
         {
         public:
-            using MultiDelegatePImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY>::MultiDelegatePImpl;
+            using MultiDelegatePImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY, Allocator>::MultiDelegatePImpl;
 
             R operator()()
             {
@@ -442,27 +495,27 @@ namespace delegate
             }
         };
 
-        template< typename Delegate, typename R, bool ISQUEUE, size_t QUEUE_CAPACITY, typename... P> class MultiDelegate;
+        template< typename Delegate, typename R, bool ISQUEUE, size_t QUEUE_CAPACITY, typename Allocator, typename... P> class MultiDelegate;
 
-        template< typename Delegate, typename R, bool ISQUEUE, size_t QUEUE_CAPACITY, typename... P>
-        class MultiDelegate<Delegate, R(P...), ISQUEUE, QUEUE_CAPACITY> : public MultiDelegatePImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY, P...>
+        template< typename Delegate, typename R, bool ISQUEUE, size_t QUEUE_CAPACITY, typename Allocator, typename... P>
+        class MultiDelegate<Delegate, R(P...), ISQUEUE, QUEUE_CAPACITY, Allocator> : public MultiDelegatePImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY, Allocator, P...>
         {
         public:
-            using MultiDelegatePImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY, P...>::MultiDelegatePImpl;
+            using MultiDelegatePImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY, Allocator, P...>::MultiDelegatePImpl;
         };
 
-        template< typename Delegate, typename R, bool ISQUEUE, size_t QUEUE_CAPACITY>
-        class MultiDelegate<Delegate, R(), ISQUEUE, QUEUE_CAPACITY> : public MultiDelegateImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY>
+        template< typename Delegate, typename R, bool ISQUEUE, size_t QUEUE_CAPACITY, typename Allocator>
+        class MultiDelegate<Delegate, R(), ISQUEUE, QUEUE_CAPACITY, Allocator> : public MultiDelegateImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY, Allocator>
         {
         public:
-            using MultiDelegateImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY>::MultiDelegateImpl;
+            using MultiDelegateImpl<Delegate, R, ISQUEUE, QUEUE_CAPACITY, Allocator>::MultiDelegateImpl;
         };
 
-        template< typename Delegate, bool ISQUEUE, size_t QUEUE_CAPACITY, typename... P>
-        class MultiDelegate<Delegate, void(P...), ISQUEUE, QUEUE_CAPACITY> : public MultiDelegatePImpl<Delegate, void, ISQUEUE, QUEUE_CAPACITY, P...>
+        template< typename Delegate, bool ISQUEUE, size_t QUEUE_CAPACITY, typename Allocator, typename... P>
+        class MultiDelegate<Delegate, void(P...), ISQUEUE, QUEUE_CAPACITY, Allocator> : public MultiDelegatePImpl<Delegate, void, ISQUEUE, QUEUE_CAPACITY, Allocator, P...>
         {
         public:
-            using MultiDelegatePImpl<Delegate, void, ISQUEUE, QUEUE_CAPACITY, P...>::MultiDelegatePImpl;
+            using MultiDelegatePImpl<Delegate, void, ISQUEUE, QUEUE_CAPACITY, Allocator, P...>::MultiDelegatePImpl;
 
             void operator()(P... args)
             {
@@ -496,11 +549,11 @@ namespace delegate
             }
         };
 
-        template< typename Delegate, bool ISQUEUE, size_t QUEUE_CAPACITY>
-        class MultiDelegate<Delegate, void(), ISQUEUE, QUEUE_CAPACITY> : public MultiDelegateImpl<Delegate, void, ISQUEUE, QUEUE_CAPACITY>
+        template< typename Delegate, bool ISQUEUE, size_t QUEUE_CAPACITY, typename Allocator>
+        class MultiDelegate<Delegate, void(), ISQUEUE, QUEUE_CAPACITY, Allocator> : public MultiDelegateImpl<Delegate, void, ISQUEUE, QUEUE_CAPACITY, Allocator>
         {
         public:
-            using MultiDelegateImpl<Delegate, void, ISQUEUE, QUEUE_CAPACITY>::MultiDelegateImpl;
+            using MultiDelegateImpl<Delegate, void, ISQUEUE, QUEUE_CAPACITY, Allocator>::MultiDelegateImpl;
 
             void operator()()
             {
@@ -557,12 +610,25 @@ It is designed to be used with Delegate, the efficient runtime wrapper for C fun
 @tparam QUEUE_CAPACITY is only used if ISQUEUE == true. Then, it sets the maximum capacity that the queue dynamically
                allocates from the heap. Unused items are not returned to the heap, but are managed by the MultiDelegate
                instance during its own lifetime for efficiency.
+@tparam Allocator is rebound to the internal item type, and allocates and frees the items. The default, delegate::heap_allocator,
+               uses new and delete. A pool allocator with capacity for QUEUE_CAPACITY items, like ghostl::lfllist_allocator,
+               makes adding items to a MultiDelegate queue free of heap allocation, e.g. for scheduling from an ISR.
 */
-template< typename Delegate, bool ISQUEUE = false, size_t QUEUE_CAPACITY = 32>
-class MultiDelegate : public delegate::detail::MultiDelegate<Delegate, typename Delegate::target_type, ISQUEUE, QUEUE_CAPACITY>
+template< typename Delegate, bool ISQUEUE = false, size_t QUEUE_CAPACITY = 32, typename Allocator = delegate::heap_allocator<Delegate>>
+class MultiDelegate : public delegate::detail::MultiDelegate<Delegate, typename Delegate::target_type, ISQUEUE, QUEUE_CAPACITY, Allocator>
 {
 public:
-    using delegate::detail::MultiDelegate<Delegate, typename Delegate::target_type, ISQUEUE, QUEUE_CAPACITY>::MultiDelegate;
+    using delegate::detail::MultiDelegate<Delegate, typename Delegate::target_type, ISQUEUE, QUEUE_CAPACITY, Allocator>::MultiDelegate;
 };
 
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+#include "lfllist_allocator.h"
+
+/**
+A MultiDelegate queue whose QUEUE_CAPACITY items are allocated from inline storage, instead of the heap.
+*/
+template< typename Delegate, size_t QUEUE_CAPACITY = 32>
+using PooledMultiDelegateQueue = MultiDelegate<Delegate, true, QUEUE_CAPACITY, ghostl::lfllist_allocator<Delegate, QUEUE_CAPACITY>>;
+#endif
+
 #endif // __MULTIDELEGATE_H
@@ -24,10 +24,14 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 namespace ghostl
 {
-    template<typename T = void>
-    struct async_queue : private lfllist<T>
+    /// <summary>
+    /// With the lfllist_deferred_reclaim policy for Reclaim, call reclaim() at quiescent points
+    /// to destroy the popped nodes.
+    /// </summary>
+    template<typename T = void, typename Reclaim = lfllist_immediate_reclaim>
+    struct async_queue : private lfllist<T, std::allocator<detail::lfllist_node_type<T>>, void, Reclaim>
     {
-        using lfllist_type = lfllist<T>;
+        using lfllist_type = lfllist<T, std::allocator<detail::lfllist_node_type<T>>, void, Reclaim>;
 
         async_queue()
         {
@@ -73,6 +77,10 @@ namespace ghostl
                 if (T item; lfllist_type::try_pop(item)) {}
             }
         }
+        auto reclaim() -> std::size_t
+        {
+            return tcs_queue.reclaim() + lfllist_type::reclaim();
+        }
         auto pop() -> ghostl::task<T>
         {
             auto tcs = tcs_queue.back();
@@ -86,7 +94,7 @@ namespace ghostl
         }
 
     private:
-        ghostl::lfllist<task_completion_source<>> tcs_queue;
+        ghostl::lfllist<task_completion_source<>, std::allocator<detail::lfllist_node_type<task_completion_source<>>>, void, Reclaim> tcs_queue;
         std::atomic<typename decltype(tcs_queue)::node_type*> cur_tcs;
     };
 }
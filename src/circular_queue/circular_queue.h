@@ -39,6 +39,21 @@ using std::min;
 #define IRAM_ATTR
 #endif
 
+/*
+    CIRCULAR_QUEUE_CACHE_LINE: if non-zero, the cache line size in bytes. The producer and consumer
+    positions are then aligned to separate cache lines, preventing false sharing between CPU cores,
+    and each side keeps a copy of the other side's position, that it only reloads when the queue
+    seems full or empty. The default is 64 for host builds. The ESP8266 and ESP32 do not cache
+    their internal data RAM, there the alignment only costs RAM.
+*/
+#ifndef CIRCULAR_QUEUE_CACHE_LINE
+#if defined(ARDUINO)
+#define CIRCULAR_QUEUE_CACHE_LINE 0
+#else
+#define CIRCULAR_QUEUE_CACHE_LINE 64
+#endif
+#endif
+
 #if defined(__GNUC__)
 #undef ALWAYS_INLINE_ATTR
 #define ALWAYS_INLINE_ATTR __attribute__((always_inline))
@@ -46,19 +61,46 @@ using std::min;
 #define ALWAYS_INLINE_ATTR
 #endif
 
+/*!
+    @brief  Deleter for std::unique_ptr that can also hold objects or arrays in user-provided
+            storage, which are not deleted.
+*/
+template< typename T > struct borrowing_deleter
+{
+    constexpr borrowing_deleter(bool owned = true) : owned(owned) {}
+    bool owned;
+    void operator()(T* object) const
+    {
+        if (owned) delete object;
+    }
+};
+
+template< typename T > struct borrowing_deleter<T[]>
+{
+    constexpr borrowing_deleter(bool owned = true) : owned(owned) {}
+    bool owned;
+    void operator()(T* buffer) const
+    {
+        if (owned) delete[] buffer;
+    }
+};
+
 /*!
     @brief  Instance class for a single-producer, single-consumer circular queue / ring buffer (FIFO).
             This implementation is lock-free between producer and consumer for the available(), peek(),
             pop(), and push() type functions.
+            If PowerOfTwo is set, the capacity is rounded up to a power of two, and the positions
+            are free-running counters that are masked to index the buffer, instead of wrapping around
+            a sentinel element.
 */
-template< typename T, typename ForEachArg = void >
+template< typename T, typename ForEachArg = void, bool PowerOfTwo = false >
 class circular_queue
 {
 public:
     /*!
         @brief  Constructs a valid, but zero-capacity dummy queue.
     */
-    circular_queue() : m_bufSize(1)
+    circular_queue() : m_bufSize(bufSize(0))
     {
         m_inPos.store(0);
         m_outPos.store(0);
@@ -66,11 +108,24 @@ public:
     /*!
         @brief  Constructs a queue of the given maximum capacity.
     */
-    circular_queue(const size_t capacity) : m_bufSize(capacity + 1), m_buffer(new T[m_bufSize])
+    circular_queue(const size_t capacity) : m_bufSize(bufSize(capacity)), m_buffer(new T[m_bufSize])
     {
         m_inPos.store(0);
         m_outPos.store(0);
     }
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+    /*!
+        @brief  Constructs a queue of the given maximum capacity on external storage
+                of capacity + 1 elements, or for PowerOfTwo, of capacity elements, where
+                a capacity that is not a power of two is rounded down to one.
+                The storage must outlive the queue.
+    */
+    circular_queue(T* storage, const size_t capacity) : m_bufSize(storageBufSize(capacity)), m_buffer(storage, borrowing_deleter<T[]>{ false })
+    {
+        m_inPos.store(0);
+        m_outPos.store(0);
+    }
+#endif
     circular_queue(circular_queue&& cq) :
         m_bufSize(cq.m_bufSize), m_buffer(cq.m_buffer), m_inPos(cq.m_inPos.load()), m_outPos(cq.m_outPos.load())
     {}
@@ -93,11 +148,12 @@ public:
     */
     size_t capacity() const
     {
-        return m_bufSize - 1;
+        return PowerOfTwo ? m_bufSize : m_bufSize - 1;
     }
 
     /*!
         @brief  Resize the queue. The available elements in the queue are preserved.
+                For PowerOfTwo, the capacity is rounded up to a power of two.
                 This is not lock-free and concurrent producer or consumer access
                 will lead to corruption.
         @return True if the new capacity could accommodate the present elements in
@@ -110,7 +166,9 @@ public:
     */
     void flush()
     {
-        m_outPos.store(m_inPos.load());
+        const auto inPos = m_inPos.load();
+        cacheInPos(inPos);
+        m_outPos.store(inPos);
     }
 
     /*!
@@ -118,9 +176,7 @@ public:
     */
     size_t IRAM_ATTR available() const
     {
-        int avail = static_cast<int>(m_inPos.load() - m_outPos.load());
-        if (avail < 0) avail += static_cast<int>(m_bufSize);
-        return avail;
+        return count(m_inPos.load(), m_outPos.load());
     }
 
     /*!
@@ -128,9 +184,8 @@ public:
     */
     size_t IRAM_ATTR available_for_push() const
     {
-        int avail = static_cast<int>(m_outPos.load() - m_inPos.load()) - 1;
-        if (avail < 0) avail += static_cast<int>(m_bufSize);
-        return avail;
+        const auto outPos = m_outPos.load();
+        return capacity() - count(m_inPos.load(), outPos);
     }
 
     /*!
@@ -142,7 +197,7 @@ public:
     {
         const auto outPos = m_outPos.load(std::memory_order_relaxed);
         std::atomic_thread_fence(std::memory_order_acquire);
-        return m_buffer[outPos];
+        return m_buffer[index(outPos)];
     }
 
     /*!
@@ -153,7 +208,7 @@ public:
     {
         const auto inPos = m_inPos.load(std::memory_order_relaxed);
         std::atomic_thread_fence(std::memory_order_acquire);
-        return m_buffer[inPos];
+        return m_buffer[index(inPos)];
     }
 
     /*!
@@ -164,12 +219,11 @@ public:
     bool IRAM_ATTR push()
     {
         const auto inPos = m_inPos.load(std::memory_order_acquire);
-        const size_t next = (inPos + 1) % m_bufSize;
-        if (next == m_outPos.load(std::memory_order_relaxed)) {
+        if (full(inPos)) {
             return false;
         }
         std::atomic_thread_fence(std::memory_order_release);
-        m_inPos.store(next, std::memory_order_release);
+        m_inPos.store(advance(inPos), std::memory_order_release);
         return true;
     }
 
@@ -181,13 +235,12 @@ public:
     bool IRAM_ATTR push(T&& val)
     {
         const auto inPos = m_inPos.load(std::memory_order_acquire);
-        const size_t next = (inPos + 1) % m_bufSize;
-        if (next == m_outPos.load(std::memory_order_relaxed)) {
+        if (full(inPos)) {
             return false;
         }
-        m_buffer[inPos] = std::move(val);
+        m_buffer[index(inPos)] = std::move(val);
         std::atomic_thread_fence(std::memory_order_release);
-        m_inPos.store(next, std::memory_order_release);
+        m_inPos.store(advance(inPos), std::memory_order_release);
         return true;
     }
 
@@ -210,6 +263,30 @@ public:
                 from the buffer head.
     */
     size_t push_n(const T* buffer, size_t size);
+
+    /*!
+        @brief  Get in-place access to the contiguous block of free elements that
+                push_n() would fill first. Release the elements written into
+                the block into the queue by commit(n).
+        @return The number of elements in the block.
+    */
+    size_t reserve_block(T*& block) const;
+
+    /*!
+        @brief  Get in-place access to all free elements, as the contiguous block that
+                push_n() would fill first, followed by the block that wraps around to the
+                start of the buffer, which is empty unless needed.
+                Release the elements written into the blocks into the queue by commit(n).
+        @return The total number of elements in both blocks.
+    */
+    size_t reserve_blocks(T*& block, size_t& size, T*& wrapBlock, size_t& wrapSize) const;
+
+    /*!
+        @brief  Release elements, written in place after reserve_block() or reserve_blocks(),
+                into the queue, in order.
+        @return The number of elements actually released, up to size.
+    */
+    size_t commit(size_t size);
 #endif
 
     /*!
@@ -217,7 +294,7 @@ public:
         @return An rvalue copy of the popped element, or a default
                 value of type T if the queue is empty.
     */
-    T pop();
+    T IRAM_ATTR pop();
 
 #if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
     /*!
@@ -227,6 +304,24 @@ public:
                 buffer.
     */
     size_t pop_n(T* buffer, size_t size);
+
+    /*!
+        @brief  Get in-place access to the contiguous block of available elements,
+                beginning at the next element pop will return. Available elements that
+                wrap around to the start of the buffer are not part of the block.
+                Remove the processed elements from the queue by pop_n(nullptr, n).
+        @return The number of elements in the block.
+    */
+    size_t peek_block(T*& block) const;
+
+    /*!
+        @brief  Get in-place access to all available elements, as the contiguous block
+                beginning at the next element pop will return, followed by the block that
+                wraps around to the start of the buffer, which is empty unless needed.
+                Remove the processed elements from the queue by pop_n(nullptr, n).
+        @return The total number of elements in both blocks.
+    */
+    size_t peek_blocks(T*& block, size_t& size, T*& wrapBlock, size_t& wrapSize) const;
 #endif
 
     /*!
@@ -239,6 +334,20 @@ public:
     void for_each(Delegate<void(T&&), ForEachArg> fun);
 #endif
 
+    /*!
+        @brief  Remove all elements available at the time of the call from the queue,
+                calling back fun with the contiguous span of these elements
+                beginning at the next element pop would return, and a second time with the span
+                that wraps around to the start of the buffer, if any. The callback may move from
+                the elements. The consumer position is published once, after all callbacks.
+        @return The number of elements removed.
+    */
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+    size_t for_each_span(const Delegate<void(T*, size_t), ForEachArg>& fun);
+#else
+    size_t for_each_span(Delegate<void(T*, size_t), ForEachArg> fun);
+#endif
+
     /*!
         @brief  In reverse order, iterate over, pop and optionally requeue each available element from the queue,
                 calling back fun with a reference of every single element.
@@ -252,134 +361,336 @@ public:
 #endif
 
 protected:
+    static size_t bufSize(const size_t capacity)
+    {
+        if (!PowerOfTwo) return capacity + 1;
+        size_t size = capacity ? 1 : 0;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+    // the same as bufSize(), rounding down instead, such that the buffer fits into external storage
+    static size_t storageBufSize(const size_t capacity)
+    {
+        if (!PowerOfTwo) return capacity + 1;
+        if (!capacity) return 0;
+        size_t size = 1;
+        while (size <= (capacity >> 1)) size <<= 1;
+        return size;
+    }
+    // the buffer index of position pos
+    inline size_t IRAM_ATTR index(const size_t pos) const ALWAYS_INLINE_ATTR
+    {
+        return PowerOfTwo ? pos & (m_bufSize - 1) : pos;
+    }
+    // the position n, at most m_bufSize, elements after pos
+    inline size_t IRAM_ATTR advance(size_t pos, const size_t n = 1) const ALWAYS_INLINE_ATTR
+    {
+        pos += n;
+        return (!PowerOfTwo && pos >= m_bufSize) ? pos - m_bufSize : pos;
+    }
+    // the position of the element before pos
+    inline size_t retreat(const size_t pos) const ALWAYS_INLINE_ATTR
+    {
+        return (!PowerOfTwo && !pos) ? m_bufSize - 1 : pos - 1;
+    }
+    // the number of elements between the positions
+    inline size_t IRAM_ATTR count(const size_t inPos, const size_t outPos) const ALWAYS_INLINE_ATTR
+    {
+        return (PowerOfTwo || inPos >= outPos) ? inPos - outPos : m_bufSize - outPos + inPos;
+    }
+    inline bool IRAM_ATTR full(const size_t inPos, const size_t outPos) const ALWAYS_INLINE_ATTR
+    {
+        return PowerOfTwo ? inPos - outPos >= m_bufSize : advance(inPos) == outPos;
+    }
+    // producer side check for free space
+    inline bool IRAM_ATTR full(const size_t inPos) ALWAYS_INLINE_ATTR
+    {
+#if CIRCULAR_QUEUE_CACHE_LINE
+        if (!full(inPos, m_outPosCache)) return false;
+        m_outPosCache = m_outPos.load(std::memory_order_relaxed);
+        return full(inPos, m_outPosCache);
+#else
+        return full(inPos, m_outPos.load(std::memory_order_relaxed));
+#endif
+    }
+    // consumer side check for available elements
+    inline bool IRAM_ATTR empty(const size_t outPos) ALWAYS_INLINE_ATTR
+    {
+#if CIRCULAR_QUEUE_CACHE_LINE
+        if (m_inPosCache != outPos) return false;
+        m_inPosCache = m_inPos.load(std::memory_order_relaxed);
+        return m_inPosCache == outPos;
+#else
+        return m_inPos.load(std::memory_order_relaxed) == outPos;
+#endif
+    }
+    // Multi-element updates of the own position must refresh the copy of the other side's,
+    // keeping it less than a capacity behind.
+    inline void cacheOutPos(const size_t outPos) ALWAYS_INLINE_ATTR
+    {
+#if CIRCULAR_QUEUE_CACHE_LINE
+        m_outPosCache = outPos;
+#else
+        (void)outPos;
+#endif
+    }
+    inline void cacheInPos(const size_t inPos) ALWAYS_INLINE_ATTR
+    {
+#if CIRCULAR_QUEUE_CACHE_LINE
+        m_inPosCache = inPos;
+#else
+        (void)inPos;
+#endif
+    }
+
     size_t m_bufSize;
 #if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
-    std::unique_ptr<T[]> m_buffer;
+    // deletes the buffer unless it is external storage
+    std::unique_ptr<T[], borrowing_deleter<T[]> > m_buffer;
 #else
     std::unique_ptr<T> m_buffer;
 #endif
+#if CIRCULAR_QUEUE_CACHE_LINE
+    alignas(CIRCULAR_QUEUE_CACHE_LINE) std::atomic<size_t> m_inPos;
+    // the producer's copy of m_outPos
+    size_t m_outPosCache = 0;
+    alignas(CIRCULAR_QUEUE_CACHE_LINE) std::atomic<size_t> m_outPos;
+    // the consumer's copy of m_inPos
+    size_t m_inPosCache = 0;
+#else
     std::atomic<size_t> m_inPos;
     std::atomic<size_t> m_outPos;
+#endif
 };
 
-template< typename T, typename ForEachArg >
-bool circular_queue<T, ForEachArg>::capacity(const size_t cap)
+template< typename T, typename ForEachArg, bool PowerOfTwo >
+bool circular_queue<T, ForEachArg, PowerOfTwo>::capacity(const size_t cap)
 {
-    if (cap + 1 == m_bufSize) return true;
+    const size_t size = bufSize(cap);
+    if (size == m_bufSize) return true;
     else if (available() > cap) return false;
-    std::unique_ptr<T[] > buffer(new T[cap + 1]);
+    T* const buffer = new T[size];
     const auto available = pop_n(buffer, cap);
-    m_buffer.reset(buffer);
-    m_bufSize = cap + 1;
+    // the new buffer is owned, even if the previous one was external storage
+    m_buffer = decltype(m_buffer)(buffer);
+    m_bufSize = size;
     m_inPos.store(available, std::memory_order_relaxed);
     m_outPos.store(0, std::memory_order_relaxed);
+    cacheOutPos(0);
+    cacheInPos(available);
     return true;
 }
 
 #if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
-template< typename T, typename ForEachArg >
-size_t circular_queue<T, ForEachArg>::push_n(const T* buffer, size_t size)
+template< typename T, typename ForEachArg, bool PowerOfTwo >
+size_t circular_queue<T, ForEachArg, PowerOfTwo>::push_n(const T* buffer, size_t size)
 {
     const auto inPos = m_inPos.load(std::memory_order_acquire);
     const auto outPos = m_outPos.load(std::memory_order_relaxed);
 
-    size_t blockSize = (outPos > inPos) ? outPos - 1 - inPos : (outPos == 0) ? m_bufSize - 1 - inPos : m_bufSize - inPos;
-    blockSize = min(size, blockSize);
-    if (!blockSize) return 0;
-    int next = (inPos + blockSize) % m_bufSize;
+    size = min(size, capacity() - count(inPos, outPos));
+    if (!size) return 0;
+    cacheOutPos(outPos);
+    const size_t blockSize = min(size, m_bufSize - index(inPos));
+
+    std::copy_n(std::make_move_iterator(buffer), blockSize, m_buffer.get() + index(inPos));
+    std::copy_n(std::make_move_iterator(buffer + blockSize), size - blockSize, m_buffer.get());
+
+    std::atomic_thread_fence(std::memory_order_release);
+    m_inPos.store(advance(inPos, size), std::memory_order_release);
+    return size;
+}
+
+template< typename T, typename ForEachArg, bool PowerOfTwo >
+size_t circular_queue<T, ForEachArg, PowerOfTwo>::reserve_block(T*& block) const
+{
+    T* wrapBlock;
+    size_t size;
+    size_t wrapSize;
+    reserve_blocks(block, size, wrapBlock, wrapSize);
+    return size;
+}
 
-    auto dest = m_buffer.get() + inPos;
-    std::copy_n(std::make_move_iterator(buffer), blockSize, dest);
-    size = min(size - blockSize, outPos > 1 ? static_cast<size_t>(outPos - next - 1) : 0);
-    next += size;
-    dest = m_buffer.get();
-    std::copy_n(std::make_move_iterator(buffer + blockSize), size, dest);
+template< typename T, typename ForEachArg, bool PowerOfTwo >
+size_t circular_queue<T, ForEachArg, PowerOfTwo>::reserve_blocks(T*& block, size_t& size, T*& wrapBlock, size_t& wrapSize) const
+{
+    const auto inPos = m_inPos.load(std::memory_order_acquire);
+    const auto outPos = m_outPos.load(std::memory_order_relaxed);
+
+    const size_t avail = capacity() - count(inPos, outPos);
+    block = m_buffer.get() + index(inPos);
+    wrapBlock = m_buffer.get();
+    size = min(avail, m_bufSize - index(inPos));
+    wrapSize = avail - size;
+    return avail;
+}
 
+template< typename T, typename ForEachArg, bool PowerOfTwo >
+size_t circular_queue<T, ForEachArg, PowerOfTwo>::commit(size_t size)
+{
+    const auto inPos = m_inPos.load(std::memory_order_acquire);
+    const auto outPos = m_outPos.load(std::memory_order_relaxed);
+    size = min(size, capacity() - count(inPos, outPos));
+    cacheOutPos(outPos);
     std::atomic_thread_fence(std::memory_order_release);
-    m_inPos.store(next, std::memory_order_release);
-    return blockSize + size;
+    m_inPos.store(advance(inPos, size), std::memory_order_release);
+    return size;
 }
 #endif
 
-template< typename T, typename ForEachArg >
-T circular_queue<T, ForEachArg>::pop()
+template< typename T, typename ForEachArg, bool PowerOfTwo >
+T IRAM_ATTR circular_queue<T, ForEachArg, PowerOfTwo>::pop()
 {
     const auto outPos = m_outPos.load(std::memory_order_acquire);
-    if (m_inPos.load(std::memory_order_relaxed) == outPos) return {};
+    if (empty(outPos)) return {};
 
     std::atomic_thread_fence(std::memory_order_acquire);
 
-    auto val = std::move(m_buffer[outPos]);
+    auto val = std::move(m_buffer[index(outPos)]);
 
-    m_outPos.store((outPos + 1) % m_bufSize, std::memory_order_release);
+    m_outPos.store(advance(outPos), std::memory_order_release);
     return val;
 }
 
 #if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
-template< typename T, typename ForEachArg >
-size_t circular_queue<T, ForEachArg>::pop_n(T* buffer, size_t size) {
-    size_t avail = size = min(size, available());
-    if (!avail) return 0;
+template< typename T, typename ForEachArg, bool PowerOfTwo >
+size_t circular_queue<T, ForEachArg, PowerOfTwo>::pop_n(T* buffer, size_t size) {
     const auto outPos = m_outPos.load(std::memory_order_acquire);
-    size_t n = min(avail, static_cast<size_t>(m_bufSize - outPos));
+    const auto inPos = m_inPos.load(std::memory_order_relaxed);
+    size_t avail = size = min(size, count(inPos, outPos));
+    if (!avail) return 0;
+    cacheInPos(inPos);
+    size_t n = min(avail, static_cast<size_t>(m_bufSize - index(outPos)));
 
     std::atomic_thread_fence(std::memory_order_acquire);
 
     if (buffer) {
-        buffer = std::copy_n(std::make_move_iterator(m_buffer.get() + outPos), n, buffer);
+        buffer = std::copy_n(std::make_move_iterator(m_buffer.get() + index(outPos)), n, buffer);
         avail -= n;
         std::copy_n(std::make_move_iterator(m_buffer.get()), avail, buffer);
     }
 
-    m_outPos.store((outPos + size) % m_bufSize, std::memory_order_release);
+    m_outPos.store(advance(outPos, size), std::memory_order_release);
     return size;
 }
+
+template< typename T, typename ForEachArg, bool PowerOfTwo >
+size_t circular_queue<T, ForEachArg, PowerOfTwo>::peek_block(T*& block) const {
+    const auto outPos = m_outPos.load(std::memory_order_acquire);
+    const auto inPos = m_inPos.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    block = m_buffer.get() + index(outPos);
+    return min(count(inPos, outPos), m_bufSize - index(outPos));
+}
+
+template< typename T, typename ForEachArg, bool PowerOfTwo >
+size_t circular_queue<T, ForEachArg, PowerOfTwo>::peek_blocks(T*& block, size_t& size, T*& wrapBlock, size_t& wrapSize) const {
+    const auto outPos = m_outPos.load(std::memory_order_acquire);
+    const auto inPos = m_inPos.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const size_t avail = count(inPos, outPos);
+    block = m_buffer.get() + index(outPos);
+    wrapBlock = m_buffer.get();
+    size = min(avail, m_bufSize - index(outPos));
+    wrapSize = avail - size;
+    return avail;
+}
 #endif
 
-template< typename T, typename ForEachArg >
+template< typename T, typename ForEachArg, bool PowerOfTwo >
 #if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
-void circular_queue<T, ForEachArg>::for_each(const Delegate<void(T&&), ForEachArg>& fun)
+void circular_queue<T, ForEachArg, PowerOfTwo>::for_each(const Delegate<void(T&&), ForEachArg>& fun)
 #else
-void circular_queue<T, ForEachArg>::for_each(Delegate<void(T&&), ForEachArg> fun)
+void circular_queue<T, ForEachArg, PowerOfTwo>::for_each(Delegate<void(T&&), ForEachArg> fun)
 #endif
 {
     auto outPos = m_outPos.load(std::memory_order_acquire);
     const auto inPos = m_inPos.load(std::memory_order_relaxed);
+    cacheInPos(inPos);
     std::atomic_thread_fence(std::memory_order_acquire);
     while (outPos != inPos)
     {
-        fun(std::move(m_buffer[outPos]));
-        outPos = (outPos + 1) % m_bufSize;
+        fun(std::move(m_buffer[index(outPos)]));
+        outPos = advance(outPos);
         m_outPos.store(outPos, std::memory_order_release);
     }
 }
 
-template< typename T, typename ForEachArg >
+template< typename T, typename ForEachArg, bool PowerOfTwo >
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+size_t circular_queue<T, ForEachArg, PowerOfTwo>::for_each_span(const Delegate<void(T*, size_t), ForEachArg>& fun)
+#else
+size_t circular_queue<T, ForEachArg, PowerOfTwo>::for_each_span(Delegate<void(T*, size_t), ForEachArg> fun)
+#endif
+{
+    const auto outPos = m_outPos.load(std::memory_order_acquire);
+    const auto inPos = m_inPos.load(std::memory_order_relaxed);
+    const size_t avail = count(inPos, outPos);
+    if (!avail) return 0;
+    cacheInPos(inPos);
+    const size_t n = min(avail, static_cast<size_t>(m_bufSize - index(outPos)));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    fun(m_buffer.get() + index(outPos), n);
+    if (avail > n) fun(m_buffer.get(), avail - n);
+    m_outPos.store(advance(outPos, avail), std::memory_order_release);
+    return avail;
+}
+
+template< typename T, typename ForEachArg, bool PowerOfTwo >
 #if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
-bool circular_queue<T, ForEachArg>::for_each_rev_requeue(const Delegate<bool(T&), ForEachArg>& fun)
+bool circular_queue<T, ForEachArg, PowerOfTwo>::for_each_rev_requeue(const Delegate<bool(T&), ForEachArg>& fun)
 #else
-bool circular_queue<T, ForEachArg>::for_each_rev_requeue(Delegate<bool(T&), ForEachArg> fun)
+bool circular_queue<T, ForEachArg, PowerOfTwo>::for_each_rev_requeue(Delegate<bool(T&), ForEachArg> fun)
 #endif
 {
-    auto inPos0 = circular_queue<T, ForEachArg>::m_inPos.load(std::memory_order_acquire);
-    auto outPos = circular_queue<T, ForEachArg>::m_outPos.load(std::memory_order_relaxed);
+    auto inPos0 = m_inPos.load(std::memory_order_acquire);
+    auto outPos = m_outPos.load(std::memory_order_relaxed);
     if (outPos == inPos0) return false;
+    cacheInPos(inPos0);
     auto pos = inPos0;
     auto outPos1 = inPos0;
-    const auto posDecr = circular_queue<T, ForEachArg>::m_bufSize - 1;
     std::atomic_thread_fence(std::memory_order_acquire);
     do {
-        pos = (pos + posDecr) % circular_queue<T, ForEachArg>::m_bufSize;
-        T&& val = std::move(circular_queue<T, ForEachArg>::m_buffer[pos]);
+        pos = retreat(pos);
+        T&& val = std::move(m_buffer[index(pos)]);
         if (fun(val))
         {
-            outPos1 = (outPos1 + posDecr) % circular_queue<T, ForEachArg>::m_bufSize;
-            if (outPos1 != pos) circular_queue<T, ForEachArg>::m_buffer[outPos1] = std::move(val);
+            outPos1 = retreat(outPos1);
+            if (outPos1 != pos) m_buffer[index(outPos1)] = std::move(val);
         }
     } while (pos != outPos);
     std::atomic_thread_fence(std::memory_order_release);
-    circular_queue<T, ForEachArg>::m_outPos.store(outPos1, std::memory_order_release);
+    m_outPos.store(outPos1, std::memory_order_release);
     return true;
 }
 
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+/*!
+    @brief  Instance class for a single-producer, single-consumer circular queue / ring buffer (FIFO)
+            of compile-time capacity. The elements are stored inline, there is no heap allocation.
+            For PowerOfTwo, N must be a power of two.
+*/
+template< typename T, size_t N, typename ForEachArg = void, bool PowerOfTwo = false >
+class circular_queue_static : public circular_queue<T, ForEachArg, PowerOfTwo>
+{
+    static_assert(!PowerOfTwo || (N && !(N & (N - 1))), "capacity must be a power of two");
+public:
+    circular_queue_static() : circular_queue<T, ForEachArg, PowerOfTwo>(m_storage, N)
+    {
+    }
+    circular_queue_static(const circular_queue_static&) = delete;
+    circular_queue_static& operator=(const circular_queue_static&) = delete;
+
+private:
+    T m_storage[PowerOfTwo ? N : N + 1];
+};
+#endif
+
+/*!
+    @brief  A circular_queue with the capacity rounded up to a power of two, using masked
+            indices and no sentinel element, which avoids the wrap-around branch at each position update.
+*/
+template< typename T, typename ForEachArg = void >
+using circular_queue_pow2 = circular_queue<T, ForEachArg, true>;
+
 #endif // __circular_queue_h
@@ -28,12 +28,27 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 using esp8266::InterruptLock;
 #endif
 
+/*!
+    @brief  Producer synchronization policy for circular_queue_mp, the default.
+            Concurrent producers reserve elements by CAS, or on the ESP8266, under an InterruptLock,
+            and the last one of overlapping producers publishes all their elements at once.
+*/
+struct mp_policy_counted {};
+
+/*!
+    @brief  Producer synchronization policy for circular_queue_mp.
+            Each element carries a sequence number, producers reserve elements by CAS and
+            publish each one individually, so a producer never holds back the elements of others.
+            The capacity is rounded up to a power of two.
+*/
+struct mp_policy_sequenced {};
+
 /*!
     @brief  Instance class for a multi-producer, single-consumer circular queue / ring buffer (FIFO).
             This implementation is lock-free between producers and consumer for the available(), peek(),
             pop(), and push() type functions.
 */
-template< typename T, typename ForEachArg = void >
+template< typename T, typename ForEachArg = void, typename Policy = mp_policy_counted >
 class circular_queue_mp : protected circular_queue<T, ForEachArg>
 {
 public:
@@ -47,7 +62,7 @@ public:
         m_inPos_mp.store(0);
         m_concurrent_mp.store(0);
     }
-    circular_queue_mp(circular_queue_mp<T, ForEachArg>&& cq) : circular_queue<T, ForEachArg>(std::move(cq))
+    circular_queue_mp(circular_queue_mp&& cq) : circular_queue<T, ForEachArg>(std::move(cq))
     {
         m_inPos_mp.store(cq.m_inPos_mp.load());
         m_concurrent_mp.store(cq.m_concurrent_mp.load());
@@ -66,6 +81,7 @@ public:
     using circular_queue<T, ForEachArg>::pop;
     using circular_queue<T, ForEachArg>::pop_n;
     using circular_queue<T, ForEachArg>::for_each;
+    using circular_queue<T, ForEachArg>::for_each_span;
     using circular_queue<T, ForEachArg>::for_each_rev_requeue;
 
     T& pushpeek() = delete;
@@ -121,12 +137,18 @@ public:
 #endif
 
 protected:
+    // The producers share no copy of m_outPos, stale stores by concurrent producers could
+    // move it back by more than the capacity. Only the positions are kept apart.
+#if CIRCULAR_QUEUE_CACHE_LINE
+    alignas(CIRCULAR_QUEUE_CACHE_LINE) std::atomic<size_t> m_inPos_mp;
+#else
     std::atomic<size_t> m_inPos_mp;
+#endif
     std::atomic<int> m_concurrent_mp;
 };
 
-template< typename T, typename ForEachArg >
-bool circular_queue_mp<T, ForEachArg>::capacity(const size_t cap)
+template< typename T, typename ForEachArg, typename Policy >
+bool circular_queue_mp<T, ForEachArg, Policy>::capacity(const size_t cap)
 {
     if (cap + 1 == circular_queue<T, ForEachArg>::m_bufSize) return true;
     else if (!circular_queue<T, ForEachArg>::capacity(cap)) return false;
@@ -136,8 +158,8 @@ bool circular_queue_mp<T, ForEachArg>::capacity(const size_t cap)
     return true;
 }
 
-template< typename T, typename ForEachArg >
-bool IRAM_ATTR circular_queue_mp<T, ForEachArg>::push(T&& val)
+template< typename T, typename ForEachArg, typename Policy >
+bool IRAM_ATTR circular_queue_mp<T, ForEachArg, Policy>::push(T&& val)
 {
     size_t inPos_mp;
     size_t next;
@@ -221,8 +243,8 @@ bool IRAM_ATTR circular_queue_mp<T, ForEachArg>::push(T&& val)
 }
 
 #if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
-template< typename T, typename ForEachArg >
-size_t circular_queue_mp<T, ForEachArg>::push_n(const T* buffer, size_t size)
+template< typename T, typename ForEachArg, typename Policy >
+size_t circular_queue_mp<T, ForEachArg, Policy>::push_n(const T* buffer, size_t size)
 {
     const auto outPos = circular_queue<T, ForEachArg>::m_outPos.load(std::memory_order_relaxed);
     size_t inPos_mp;
@@ -309,4 +331,276 @@ size_t circular_queue_mp<T, ForEachArg>::push_n(const T* buffer, size_t size)
 
 #endif
 
+/*!
+    @brief  Instance class for a multi-producer, single-consumer circular queue / ring buffer (FIFO),
+            after Dmitry Vyukov's bounded queue with per-element sequence numbers.
+            The producers are lock-free, and never disable interrupts on the ESP32.
+            available(), peek(), pop() and the other consumer functions are wait-free,
+            and only see elements in order up to the first one that is still being pushed.
+*/
+template< typename T, typename ForEachArg >
+class circular_queue_mp<T, ForEachArg, mp_policy_sequenced>
+{
+public:
+    /*!
+        @brief  Constructs a valid, but zero-capacity dummy queue.
+    */
+    circular_queue_mp() : circular_queue_mp(0)
+    {
+    }
+    /*!
+        @brief  Constructs a queue of the given maximum capacity, rounded up to a power of two.
+    */
+    circular_queue_mp(const size_t capacity)
+    {
+        m_bufSize = capacity ? 1 : 0;
+        while (m_bufSize < capacity) m_bufSize <<= 1;
+        m_mask = m_bufSize ? m_bufSize - 1 : 0;
+        // the dummy queue has a single, never free element
+        m_cells.reset(new Cell[m_bufSize ? m_bufSize : 1]);
+        for (size_t i = 0; i < m_bufSize; ++i) m_cells[i].seq.store(i, std::memory_order_relaxed);
+        if (!m_bufSize) m_cells[0].seq.store(~static_cast<size_t>(0), std::memory_order_relaxed);
+        m_inPos.store(0);
+        m_outPos.store(0);
+    }
+    circular_queue_mp(const circular_queue_mp&) = delete;
+    circular_queue_mp& operator=(const circular_queue_mp&) = delete;
+
+    /*!
+        @brief  Get the numer of elements the queue can hold at most.
+    */
+    size_t capacity() const
+    {
+        return m_bufSize;
+    }
+
+    /*!
+        @brief  Discard all data in the queue. Only call from the consumer.
+    */
+    void flush()
+    {
+        pop_n(nullptr, available());
+    }
+
+    /*!
+        @brief  Get a snapshot number of elements that can be retrieved by pop.
+                Only call from the consumer.
+    */
+    size_t IRAM_ATTR available() const;
+
+    /*!
+        @brief  Get the remaining free elementes for pushing.
+    */
+    size_t IRAM_ATTR available_for_push() const
+    {
+        const auto inPos = m_inPos.load(std::memory_order_relaxed);
+        const auto used = static_cast<intptr_t>(inPos - m_outPos.load(std::memory_order_relaxed));
+        return (used < 0) ? m_bufSize : (static_cast<size_t>(used) > m_bufSize) ? 0 : m_bufSize - used;
+    }
+
+    /*!
+        @brief  Peek at the next element pop will return without removing it from the queue.
+        @return An rvalue copy of the next element that can be popped, or a default
+                value of type T if the queue is empty.
+    */
+    T peek() const
+    {
+        const auto outPos = m_outPos.load(std::memory_order_relaxed);
+        const Cell& cell = m_cells[outPos & m_mask];
+        if (cell.seq.load(std::memory_order_acquire) != outPos + 1) return {};
+        return cell.value;
+    }
+
+    /*!
+        @brief  Move the rvalue parameter into the queue, guarded
+                for multiple concurrent producers.
+        @return true if the queue accepted the value, false if the queue
+                was full.
+    */
+    bool IRAM_ATTR push(T&& val);
+
+    /*!
+        @brief  Push a copy of the parameter into the queue, guarded
+                for multiple concurrent producers.
+        @return true if the queue accepted the value, false if the queue
+                was full.
+    */
+    inline bool IRAM_ATTR push(const T& val) ALWAYS_INLINE_ATTR
+    {
+        T v(val);
+        return push(std::move(v));
+    }
+
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+    /*!
+        @brief  Push copies of multiple elements from a buffer into the queue,
+                in order, beginning at buffer's head. This is safe for
+                multiple producers.
+        @return The number of elements actually copied into the queue, counted
+                from the buffer head.
+    */
+    size_t push_n(const T* buffer, size_t size);
+#endif
+
+    /*!
+        @brief  Pop the next available element from the queue.
+        @return An rvalue copy of the popped element, or a default
+                value of type T if the queue is empty.
+    */
+    T IRAM_ATTR pop();
+
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+    /*!
+        @brief  Pop multiple elements in ordered sequence from the queue to a buffer.
+                If buffer is nullptr, simply discards up to size elements from the queue.
+        @return The number of elements actually popped from the queue to
+                buffer.
+    */
+    size_t pop_n(T* buffer, size_t size);
+#endif
+
+    /*!
+        @brief  Iterate over and remove each available element from queue,
+                calling back fun with an rvalue reference of every single element.
+    */
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+    void for_each(const Delegate<void(T&&), ForEachArg>& fun);
+#else
+    void for_each(Delegate<void(T&&), ForEachArg> fun);
+#endif
+
+protected:
+    struct Cell
+    {
+        // the position + 1 once the value is pushed, or the position of the next round once popped
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    size_t m_bufSize;
+    size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+#if CIRCULAR_QUEUE_CACHE_LINE
+    alignas(CIRCULAR_QUEUE_CACHE_LINE) std::atomic<size_t> m_inPos;
+    alignas(CIRCULAR_QUEUE_CACHE_LINE) std::atomic<size_t> m_outPos;
+#else
+    std::atomic<size_t> m_inPos;
+    std::atomic<size_t> m_outPos;
+#endif
+    // the consumer's position up to which all elements are known to be pushed
+    mutable size_t m_pushedPos = 0;
+};
+
+template< typename T, typename ForEachArg >
+size_t IRAM_ATTR circular_queue_mp<T, ForEachArg, mp_policy_sequenced>::available() const
+{
+    const auto outPos = m_outPos.load(std::memory_order_relaxed);
+    auto pos = m_pushedPos;
+    if (static_cast<intptr_t>(pos - outPos) < 0) pos = outPos;
+    // each element is checked only once, until pushed
+    while (pos - outPos < m_bufSize && m_cells[pos & m_mask].seq.load(std::memory_order_acquire) == pos + 1) ++pos;
+    m_pushedPos = pos;
+    return pos - outPos;
+}
+
+template< typename T, typename ForEachArg >
+bool IRAM_ATTR circular_queue_mp<T, ForEachArg, mp_policy_sequenced>::push(T&& val)
+{
+    auto pos = m_inPos.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;)
+    {
+        cell = &m_cells[pos & m_mask];
+        const auto seq = cell->seq.load(std::memory_order_acquire);
+        const auto dif = static_cast<intptr_t>(seq - pos);
+        if (dif == 0)
+        {
+            if (m_inPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        }
+        else if (dif < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = m_inPos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->value = std::move(val);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+template< typename T, typename ForEachArg >
+size_t circular_queue_mp<T, ForEachArg, mp_policy_sequenced>::push_n(const T* buffer, size_t size)
+{
+    auto pos = m_inPos.load(std::memory_order_relaxed);
+    size_t blockSize;
+    do
+    {
+        // the consumer releases the elements in order before advancing m_outPos
+        const auto free = static_cast<intptr_t>(m_outPos.load(std::memory_order_acquire) + m_bufSize - pos);
+        blockSize = (free > 0) ? min(size, static_cast<size_t>(free)) : 0;
+        if (!blockSize) return 0;
+    }
+    while (!m_inPos.compare_exchange_weak(pos, pos + blockSize, std::memory_order_relaxed));
+
+    for (size_t i = 0; i < blockSize; ++i)
+    {
+        Cell& cell = m_cells[(pos + i) & m_mask];
+        cell.value = buffer[i];
+        cell.seq.store(pos + i + 1, std::memory_order_release);
+    }
+    return blockSize;
+}
+#endif
+
+template< typename T, typename ForEachArg >
+T IRAM_ATTR circular_queue_mp<T, ForEachArg, mp_policy_sequenced>::pop()
+{
+    const auto outPos = m_outPos.load(std::memory_order_relaxed);
+    Cell& cell = m_cells[outPos & m_mask];
+    if (cell.seq.load(std::memory_order_acquire) != outPos + 1) return {};
+    auto val = std::move(cell.value);
+    cell.seq.store(outPos + m_bufSize, std::memory_order_release);
+    m_outPos.store(outPos + 1, std::memory_order_release);
+    return val;
+}
+
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+template< typename T, typename ForEachArg >
+size_t circular_queue_mp<T, ForEachArg, mp_policy_sequenced>::pop_n(T* buffer, size_t size)
+{
+    size = min(size, available());
+    if (!size) return 0;
+    const auto outPos = m_outPos.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < size; ++i)
+    {
+        Cell& cell = m_cells[(outPos + i) & m_mask];
+        if (buffer) buffer[i] = std::move(cell.value);
+        cell.seq.store(outPos + i + m_bufSize, std::memory_order_release);
+    }
+    m_outPos.store(outPos + size, std::memory_order_release);
+    return size;
+}
+#endif
+
+template< typename T, typename ForEachArg >
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+void circular_queue_mp<T, ForEachArg, mp_policy_sequenced>::for_each(const Delegate<void(T&&), ForEachArg>& fun)
+#else
+void circular_queue_mp<T, ForEachArg, mp_policy_sequenced>::for_each(Delegate<void(T&&), ForEachArg> fun)
+#endif
+{
+    auto outPos = m_outPos.load(std::memory_order_relaxed);
+    for (auto avail = available(); avail; --avail)
+    {
+        Cell& cell = m_cells[outPos & m_mask];
+        fun(std::move(cell.value));
+        cell.seq.store(outPos + m_bufSize, std::memory_order_release);
+        m_outPos.store(++outPos, std::memory_order_release);
+    }
+}
+
 #endif // __circular_queue_mp_h
@@ -0,0 +1,200 @@
+#pragma once
+/*
+circular_queue_mpmc.h - Implementation of a lock-free circular queue for EspSoftwareSerial.
+Copyright (c) 2019 Dirk O. Kaar. All rights reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __circular_queue_mpmc_h
+#define __circular_queue_mpmc_h
+
+#include "circular_queue_mp.h"
+
+/*!
+    @brief  Instance class for a multi-producer, multi-consumer circular queue / ring buffer (FIFO).
+            Producers and consumers alike reserve elements by CAS, and release them by the
+            per-element sequence numbers of mp_policy_sequenced. The capacity is rounded up to a power of two.
+            With concurrent consumers, available() and available_for_push() are only estimates,
+            use the return value of pop_n() to tell if an element was actually popped.
+*/
+template< typename T, typename ForEachArg = void >
+class circular_queue_mpmc : protected circular_queue_mp<T, ForEachArg, mp_policy_sequenced>
+{
+public:
+    using base = circular_queue_mp<T, ForEachArg, mp_policy_sequenced>;
+
+    circular_queue_mpmc() = default;
+    circular_queue_mpmc(const size_t capacity) : base(capacity)
+    {
+    }
+
+    using base::capacity;
+    using base::push;
+
+    /*!
+        @brief  Get a snapshot number of elements that are pushed or being pushed,
+                and not yet claimed by any consumer.
+    */
+    size_t IRAM_ATTR available() const
+    {
+        const auto outPos = base::m_outPos.load(std::memory_order_relaxed);
+        const auto used = static_cast<intptr_t>(base::m_inPos.load(std::memory_order_relaxed) - outPos);
+        return (used < 0) ? 0 : min(static_cast<size_t>(used), base::m_bufSize);
+    }
+
+    /*!
+        @brief  Get a snapshot number of the remaining free elements for pushing.
+    */
+    size_t IRAM_ATTR available_for_push() const
+    {
+        return base::available_for_push();
+    }
+
+    /*!
+        @brief  Discard the elements in the queue that no other consumer has claimed yet.
+    */
+    void flush()
+    {
+        while (pop_n(nullptr, base::m_bufSize)) {}
+    }
+
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+    /*!
+        @brief  Push copies of multiple elements from a buffer into the queue,
+                in order, beginning at buffer's head. This is safe for
+                multiple producers and consumers.
+        @return The number of elements actually copied into the queue, counted
+                from the buffer head.
+    */
+    size_t push_n(const T* buffer, size_t size);
+#endif
+
+    /*!
+        @brief  Pop the next available element from the queue, safe for
+                multiple concurrent consumers.
+        @return An rvalue copy of the popped element, or a default
+                value of type T if the queue is empty.
+    */
+    T IRAM_ATTR pop();
+
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+    /*!
+        @brief  Pop multiple elements in ordered sequence from the queue to a buffer,
+                safe for multiple concurrent consumers.
+                If buffer is nullptr, simply discards up to size elements from the queue.
+        @return The number of elements actually popped from the queue to
+                buffer.
+    */
+    size_t pop_n(T* buffer, size_t size);
+#endif
+
+protected:
+    using typename base::Cell;
+};
+
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+template< typename T, typename ForEachArg >
+size_t circular_queue_mpmc<T, ForEachArg>::push_n(const T* buffer, size_t size)
+{
+    if (!size) return 0;
+    // m_outPos runs ahead of the consumers releasing the elements,
+    // so free elements are found by their sequence numbers
+    auto pos = base::m_inPos.load(std::memory_order_relaxed);
+    size_t blockSize;
+    do
+    {
+        blockSize = 0;
+        while (blockSize < size && blockSize < base::m_bufSize &&
+            base::m_cells[(pos + blockSize) & base::m_mask].seq.load(std::memory_order_acquire) == pos + blockSize) ++blockSize;
+        if (!blockSize)
+        {
+            const auto seq = base::m_cells[pos & base::m_mask].seq.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(seq - pos) < 0) return 0;
+            pos = base::m_inPos.load(std::memory_order_relaxed);
+        }
+    }
+    while (!blockSize || !base::m_inPos.compare_exchange_weak(pos, pos + blockSize, std::memory_order_relaxed));
+
+    for (size_t i = 0; i < blockSize; ++i)
+    {
+        Cell& cell = base::m_cells[(pos + i) & base::m_mask];
+        cell.value = buffer[i];
+        cell.seq.store(pos + i + 1, std::memory_order_release);
+    }
+    return blockSize;
+}
+#endif
+
+template< typename T, typename ForEachArg >
+T IRAM_ATTR circular_queue_mpmc<T, ForEachArg>::pop()
+{
+    auto pos = base::m_outPos.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;)
+    {
+        cell = &base::m_cells[pos & base::m_mask];
+        const auto seq = cell->seq.load(std::memory_order_acquire);
+        const auto dif = static_cast<intptr_t>(seq - (pos + 1));
+        if (dif == 0)
+        {
+            if (base::m_outPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        }
+        else if (dif < 0)
+        {
+            return {};
+        }
+        else
+        {
+            pos = base::m_outPos.load(std::memory_order_relaxed);
+        }
+    }
+    auto val = std::move(cell->value);
+    cell->seq.store(pos + base::m_bufSize, std::memory_order_release);
+    return val;
+}
+
+#if defined(ESP8266) || defined(ESP32) || !defined(ARDUINO)
+template< typename T, typename ForEachArg >
+size_t circular_queue_mpmc<T, ForEachArg>::pop_n(T* buffer, size_t size)
+{
+    if (!size) return 0;
+    auto pos = base::m_outPos.load(std::memory_order_relaxed);
+    size_t blockSize;
+    do
+    {
+        blockSize = 0;
+        while (blockSize < size && blockSize < base::m_bufSize &&
+            base::m_cells[(pos + blockSize) & base::m_mask].seq.load(std::memory_order_acquire) == pos + blockSize + 1) ++blockSize;
+        if (!blockSize)
+        {
+            const auto seq = base::m_cells[pos & base::m_mask].seq.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(seq - (pos + 1)) < 0) return 0;
+            pos = base::m_outPos.load(std::memory_order_relaxed);
+        }
+    }
+    while (!blockSize || !base::m_outPos.compare_exchange_weak(pos, pos + blockSize, std::memory_order_relaxed));
+
+    for (size_t i = 0; i < blockSize; ++i)
+    {
+        Cell& cell = base::m_cells[(pos + i) & base::m_mask];
+        if (buffer) buffer[i] = std::move(cell.value);
+        cell.seq.store(pos + i + base::m_bufSize, std::memory_order_release);
+    }
+    return blockSize;
+}
+#endif
+
+#endif // __circular_queue_mpmc_h
@@ -0,0 +1,290 @@
+#pragma once
+/*
+executor.h - Implementation of a C++20 cooperative executor with timer wheel for ghostl coroutines.
+Copyright (c) 2023 Dirk O. Kaar. All rights reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __EXECUTOR_H
+#define __EXECUTOR_H
+
+#include "circular_queue_mp.h"
+
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#if !defined(ARDUINO)
+#include <chrono>
+#endif
+
+namespace ghostl
+{
+    namespace detail
+    {
+        inline auto executor_micros() -> std::uint32_t
+        {
+#if defined(ARDUINO)
+            return micros();
+#else
+            static const auto start = std::chrono::steady_clock::now();
+            return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+#endif
+        }
+    }
+
+    /// <summary>
+    /// Cooperative executor, resuming coroutines from a single context, loop() or a dedicated task, by run().
+    /// Handles are posted to its ready queue, which is safe from ISRs and other cores.
+    /// Timed resumption by co_await delay_us() is kept in a hashed timer wheel of SLOTS slots, each covering
+    /// TICK_US microseconds, and is only available to the coroutines that run() resumes.
+    /// The resolution of delays is that of the calls to run(), not of TICK_US.
+    /// </summary>
+    template<std::size_t SLOTS = 64, std::uint32_t TICK_US = 1024>
+    class executor
+    {
+        static_assert(SLOTS && !(SLOTS & (SLOTS - 1)), "SLOTS must be a power of two");
+        static_assert(TICK_US && !(TICK_US & (TICK_US - 1)), "TICK_US must be a power of two");
+
+        struct timer
+        {
+            std::uint32_t deadline;
+            std::coroutine_handle<> coroutine;
+            timer* next;
+        };
+
+    public:
+        explicit executor(std::size_t capacity = 16) : ready(capacity), tick(detail::executor_micros() / TICK_US)
+        {
+        }
+        executor(const executor&) = delete;
+        executor(executor&&) = delete;
+        auto operator =(const executor&)->executor & = delete;
+        auto operator =(executor&&)->executor & = delete;
+
+        /// <summary>
+        /// Queue a coroutine for resumption by run(). This is safe to call from ISRs.
+        /// </summary>
+        /// <returns>false if the ready queue is full.</returns>
+        auto IRAM_ATTR post(std::coroutine_handle<> coroutine) -> bool
+        {
+            return ready.push(coroutine);
+        }
+
+        struct schedule_awaiter final
+        {
+            constexpr bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> coroutine)
+            {
+                // resume at once if the ready queue is full
+                return exec.post(coroutine);
+            }
+            constexpr void await_resume() const noexcept {}
+            executor& exec;
+        };
+        /// <summary>
+        /// Yield to the other ready coroutines, or move a coroutine to the context of run().
+        /// </summary>
+        [[nodiscard]] auto schedule() -> schedule_awaiter
+        {
+            return { *this };
+        }
+
+        struct delay_awaiter final
+        {
+            bool await_ready() const
+            {
+                return static_cast<std::int32_t>(detail::executor_micros() - entry.deadline) >= 0;
+            }
+            void await_suspend(std::coroutine_handle<> coroutine)
+            {
+                entry.coroutine = coroutine;
+                exec.insert(entry);
+            }
+            constexpr void await_resume() const noexcept {}
+            executor& exec;
+            timer entry;
+        };
+        /// <summary>
+        /// Suspend the calling coroutine for at least us microseconds.
+        /// </summary>
+        [[nodiscard]] auto delay_us(std::uint32_t us) -> delay_awaiter
+        {
+            return { *this, { detail::executor_micros() + us, nullptr, nullptr } };
+        }
+
+        /// <summary>
+        /// Resume the coroutines that have become ready, and those whose delay has expired.
+        /// Coroutines posted during the run are resumed on the next one.
+        /// </summary>
+        /// <returns>The number of resumed coroutines.</returns>
+        auto run() -> std::size_t
+        {
+            std::size_t count = 0;
+            // retry the events that found the ready queue full
+            for (auto ev = deferred.exchange(nullptr); ev;)
+            {
+                auto next = ev->next_deferred;
+                ev->is_deferred.store(false);
+                // unless a later set() has already posted the coroutine
+                ev->wake(false);
+                ev = next;
+            }
+            for (auto n = ready.available(); n; --n)
+            {
+                if (auto coroutine = ready.pop(); coroutine)
+                {
+                    coroutine.resume();
+                    ++count;
+                }
+            }
+            const auto now = detail::executor_micros();
+            const std::uint32_t cur = now / TICK_US;
+            // sweep the slots of the elapsed ticks, or once the whole wheel after a long pause
+            const std::uint32_t elapsed = (cur - tick) & TICK_MASK;
+            const std::uint32_t steps = elapsed < SLOTS ? elapsed : SLOTS - 1;
+            tick = cur;
+            timer* expired = nullptr;
+            timer** tail = &expired;
+            for (std::uint32_t i = 0; i <= steps; ++i)
+            {
+                auto& slot = slots[(cur - steps + i) & (SLOTS - 1)];
+                timer* entry = slot;
+                slot = nullptr;
+                while (entry)
+                {
+                    timer* next = entry->next;
+                    if (static_cast<std::int32_t>(now - entry->deadline) >= 0)
+                    {
+                        entry->next = nullptr;
+                        *tail = entry;
+                        tail = &entry->next;
+                    }
+                    else
+                    {
+                        // a later revolution of the wheel
+                        entry->next = slot;
+                        slot = entry;
+                    }
+                    entry = next;
+                }
+            }
+            // resuming may destroy the expired entries, or insert new ones
+            while (expired)
+            {
+                timer* next = expired->next;
+                expired->coroutine.resume();
+                ++count;
+                expired = next;
+            }
+            return count;
+        }
+
+        /// <summary>
+        /// Awaitable event, that is set from ISRs and other contexts, resuming its single awaiting coroutine
+        /// by run(). Setting the event while no coroutine awaits it, completes the next co_await at once.
+        /// If the ready queue is full, the wakeup is retried by the next run(), so the event must
+        /// outlive the executor's runs while it is set.
+        /// </summary>
+        class event
+        {
+        public:
+            explicit event(executor& _exec) : exec(_exec) {}
+            event(const event&) = delete;
+            auto operator =(const event&)->event & = delete;
+
+            auto IRAM_ATTR set() -> void
+            {
+                wake(true);
+            }
+            bool await_ready()
+            {
+                auto cur = signalled();
+                return state.compare_exchange_strong(cur, nullptr);
+            }
+            bool await_suspend(std::coroutine_handle<> coroutine)
+            {
+                void* cur = nullptr;
+                if (state.compare_exchange_strong(cur, coroutine.address())) return true;
+                // set in the meantime
+                state.store(nullptr);
+                return false;
+            }
+            constexpr void await_resume() const noexcept {}
+
+        private:
+            void* signalled() const { return const_cast<event*>(this); }
+            // post the awaiting coroutine, or without one, if signal is true, mark the event as set
+            auto IRAM_ATTR wake(bool signal) -> void
+            {
+                auto cur = state.load();
+                for (;;)
+                {
+                    if (cur == signalled()) return;
+                    if (!cur)
+                    {
+                        if (!signal || state.compare_exchange_weak(cur, signalled())) return;
+                    }
+                    else if (state.compare_exchange_weak(cur, nullptr))
+                    {
+                        if (exec.post(std::coroutine_handle<>::from_address(cur))) return;
+                        // keep the coroutine awaiting, a concurrent set() is merged into this one
+                        state.store(cur);
+                        if (!is_deferred.exchange(true)) exec.defer(*this);
+                        return;
+                    }
+                }
+            }
+
+            friend class executor;
+            executor& exec;
+            std::atomic<void*> state{ nullptr };
+            std::atomic<bool> is_deferred{ false };
+            event* next_deferred = nullptr;
+        };
+
+    private:
+        // push an event whose wakeup found the ready queue full, safe from ISRs
+        auto IRAM_ATTR defer(event& ev) -> void
+        {
+            auto head = deferred.load();
+            do
+            {
+                ev.next_deferred = head;
+            } while (!deferred.compare_exchange_weak(head, &ev));
+        }
+
+        static constexpr std::uint32_t TICK_MASK = ~std::uint32_t{ 0 } / TICK_US;
+
+        auto insert(timer& entry) -> void
+        {
+            // a deadline that passed since the last run belongs to the slot swept next
+            const std::uint32_t at = static_cast<std::int32_t>(entry.deadline - tick * TICK_US) < 0 ?
+                tick : entry.deadline / TICK_US;
+            auto& slot = slots[at & (SLOTS - 1)];
+            entry.next = slot;
+            slot = &entry;
+        }
+
+        circular_queue_mp<std::coroutine_handle<>> ready;
+        std::atomic<event*> deferred{ nullptr };
+        std::array<timer*, SLOTS> slots{};
+        std::uint32_t tick;
+    };
+}
+
+#endif // __EXECUTOR_H
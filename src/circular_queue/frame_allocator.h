@@ -0,0 +1,147 @@
+#pragma once
+/*
+frame_allocator.h - Pluggable allocation of C++20 coroutine frames.
+Copyright (c) 2023 Dirk O. Kaar. All rights reserved.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __FRAME_ALLOCATOR_H
+#define __FRAME_ALLOCATOR_H
+
+#include "lfllist_allocator.h"
+
+#include <cstddef>
+#include <new>
+
+namespace ghostl
+{
+    /// <summary>
+    /// The allocation functions for the frames of task, generator and run_task coroutines,
+    /// by default from the heap. Replace them by set(), before any coroutine is started.
+    /// </summary>
+    struct frame_allocator
+    {
+        using allocate_fn = void* (*)(std::size_t size);
+        using deallocate_fn = void (*)(void* p, std::size_t size);
+
+        static void* heap_allocate(std::size_t size)
+        {
+            return ::operator new(size);
+        }
+        static void heap_deallocate(void* p, std::size_t)
+        {
+            ::operator delete(p);
+        }
+
+        static void set(allocate_fn _allocate, deallocate_fn _deallocate)
+        {
+            allocate = _allocate;
+            deallocate = _deallocate;
+        }
+
+        static inline allocate_fn allocate = heap_allocate;
+        static inline deallocate_fn deallocate = heap_deallocate;
+    };
+
+    /// <summary>
+    /// Base of promise types, routing their coroutine frame allocation to frame_allocator.
+    /// </summary>
+    struct frame_allocated
+    {
+        static void* operator new(std::size_t size)
+        {
+            return frame_allocator::allocate(size);
+        }
+        static void operator delete(void* p, std::size_t size)
+        {
+            frame_allocator::deallocate(p, size);
+        }
+    };
+
+    namespace detail
+    {
+        template<std::size_t SIZE, std::size_t COUNT, std::size_t CLASSES>
+        struct frame_size_classes
+        {
+            struct alignas(alignof(std::max_align_t)) block
+            {
+                char bytes[SIZE];
+            };
+
+            auto allocate(std::size_t size) -> void*
+            {
+                if (size > SIZE) return larger.allocate(size);
+                if (auto p = pool.allocate(1); p) return p;
+                return frame_allocator::heap_allocate(size);
+            }
+            auto deallocate(void* p, std::size_t size) -> void
+            {
+                if (size > SIZE) return larger.deallocate(p, size);
+                if (pool.is_inline(p)) pool.deallocate(static_cast<block*>(p), 1);
+                else frame_allocator::heap_deallocate(p, size);
+            }
+
+            lfllist_allocator<block, COUNT> pool;
+            frame_size_classes<SIZE * 2, COUNT, CLASSES - 1> larger;
+        };
+
+        template<std::size_t SIZE, std::size_t COUNT>
+        struct frame_size_classes<SIZE, COUNT, 0>
+        {
+            auto allocate(std::size_t size) -> void*
+            {
+                return frame_allocator::heap_allocate(size);
+            }
+            auto deallocate(void* p, std::size_t size) -> void
+            {
+                frame_allocator::heap_deallocate(p, size);
+            }
+        };
+    }
+
+    /// <summary>
+    /// Recycling pool of coroutine frames, in inline storage for COUNT frames in each of CLASSES size classes,
+    /// the smallest of which holding MIN_SIZE bytes, and each next one twice the size of the previous one.
+    /// Frames that are larger, or find their size class exhausted, are allocated from the heap.
+    /// Call install() to route all coroutine frames to the pool.
+    /// </summary>
+    template<std::size_t COUNT = 8, std::size_t MIN_SIZE = 64, std::size_t CLASSES = 4>
+    struct frame_pool
+    {
+        static void* allocate(std::size_t size)
+        {
+            return classes().allocate(size);
+        }
+        static void deallocate(void* p, std::size_t size)
+        {
+            classes().deallocate(p, size);
+        }
+        static void install()
+        {
+            classes();
+            frame_allocator::set(allocate, deallocate);
+        }
+
+    private:
+        static auto classes() -> detail::frame_size_classes<MIN_SIZE, COUNT, CLASSES>&
+        {
+            static detail::frame_size_classes<MIN_SIZE, COUNT, CLASSES> instance;
+            return instance;
+        }
+    };
+}
+
+#endif // __FRAME_ALLOCATOR_H
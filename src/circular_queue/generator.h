@@ -21,13 +21,14 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <atomic>
 #include <memory>
 #include <coroutine>
+#include "frame_allocator.h"
 
 namespace ghostl
 {
     template <typename T>
     struct generator
     {
-        struct promise_type
+        struct promise_type : frame_allocated
         {
             generator get_return_object() noexcept
             {
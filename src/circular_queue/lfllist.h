@@ -25,10 +25,26 @@
 
 #include <atomic>
 #include <utility>
+#include <type_traits>
 
 namespace ghostl
 {
-    template<typename T, class Allocator, typename ForEachArg>
+    /// <summary>
+    /// Reclamation policy for lfllist: nodes are destroyed on erase or pop (the default).
+    /// </summary>
+    struct lfllist_immediate_reclaim {};
+
+    /// <summary>
+    /// Reclamation policy for lfllist: erased or popped nodes are retired, and only destroyed
+    /// by reclaim(), at a quiescent point without any active read_guard, for instance from loop().
+    /// Traversals, try_pop() and push() hold a read_guard internally, such that a node pointer
+    /// that is concurrently erased or popped stays valid.
+    /// Contended unlinking is retried only a bounded number of times: erase() then leaves the node
+    /// marked for try_pop() or reclaim() to dispose of, and remove() and try_pop() report failure.
+    /// </summary>
+    struct lfllist_deferred_reclaim {};
+
+    template<typename T, class Allocator, typename ForEachArg, typename Reclaim>
     struct lfllist;
 
     namespace detail {
@@ -40,17 +56,23 @@ namespace ghostl
             lfllist_node_type() = default;
             explicit lfllist_node_type(T&& _item) : item(std::move(_item)) {}
         private:
-            template<typename, class, typename> friend struct ghostl::lfllist;
+            template<typename, class, typename, typename> friend struct ghostl::lfllist;
             std::atomic<node_type*> pred{ nullptr };
             std::atomic<node_type*> next{ nullptr };
             std::atomic<bool> remove_lock{ false };
+            // erased with deferred reclamation, but still linked, skipped by back() and try_pop()
+            std::atomic<bool> erased{ false };
         };
     };
 
-    template<typename T, class Allocator = std::allocator<detail::lfllist_node_type<T>>, typename ForEachArg = void>
+    template<typename T, class Allocator = std::allocator<detail::lfllist_node_type<T>>, typename ForEachArg = void,
+        typename Reclaim = lfllist_immediate_reclaim>
     struct lfllist
     {
         using node_type = detail::lfllist_node_type<T>;
+        static constexpr bool deferred_reclaim = std::is_same_v<Reclaim, lfllist_deferred_reclaim>;
+        /// The number of attempts at unlinking a contended node, with the lfllist_deferred_reclaim policy.
+        static constexpr unsigned unlink_attempts = 8;
 
         lfllist() = default;
         lfllist(const lfllist&) = delete;
@@ -59,10 +81,31 @@ namespace ghostl
         {
             node_type* node;
             while (nullptr != (node = back())) erase(node);
+            if constexpr (deferred_reclaim) reclaim();
         }
         auto operator =(const lfllist&)->lfllist & = delete;
         auto operator =(lfllist&&)->lfllist & = delete;
 
+        /// <summary>
+        /// While in scope, defers the destruction of nodes that are erased or popped,
+        /// with the lfllist_deferred_reclaim policy. Is safe for concurrency and reentrance.
+        /// </summary>
+        struct read_guard
+        {
+            explicit read_guard(const lfllist& _list) : list(_list)
+            {
+                if constexpr (deferred_reclaim) list.readers.fetch_add(1);
+            }
+            read_guard(const read_guard&) = delete;
+            ~read_guard()
+            {
+                if constexpr (deferred_reclaim) list.readers.fetch_sub(1);
+            }
+            auto operator =(const read_guard&)->read_guard & = delete;
+        private:
+            const lfllist& list;
+        };
+
         /// <summary>
         ///  Emplace an item at the list's front. Is safe for concurrency and reentrance.
         /// </summary>
@@ -85,6 +128,8 @@ namespace ghostl
         /// <returns>, nullptr on failure.</returns>
         auto IRAM_ATTR push(node_type* const node) -> void
         {
+            read_guard guard(*this);
+            if constexpr (deferred_reclaim) node->erased.store(false);
             auto next = first.exchange(node);
             node->next.store(next);
             std::atomic_thread_fence(std::memory_order_release);
@@ -99,9 +144,23 @@ namespace ghostl
         /// Caveat: for_each() or try_pop() may erase any node pointer.
         /// </summary>
         /// <param name="node">A node (not nullptr) that must be a member of this list.</param>
-        auto remove(node_type* const node) -> void
+        /// <returns>True on success. With the lfllist_deferred_reclaim policy, false if the node remains
+        /// a member, because locking it is still contended after unlink_attempts.</returns>
+        auto remove(node_type* const node) -> bool
         {
-            while (!try_remove(node)) {}
+            if constexpr (deferred_reclaim)
+            {
+                for (unsigned attempt = 0; attempt < unlink_attempts; ++attempt)
+                {
+                    if (try_remove(node)) return true;
+                }
+                return false;
+            }
+            else
+            {
+                while (!try_remove(node)) {}
+                return true;
+            }
         }
 
         /// <summary>
@@ -114,86 +173,139 @@ namespace ghostl
         /// <returns>True on success, false if there is competition on locking node.</returns>
         auto try_remove(node_type* const node) -> bool
         {
-            auto _false = false;
-            if (!node->remove_lock.compare_exchange_strong(_false, true)) { return false; }
-            node_type* next = nullptr;
-            node_type* pred = nullptr;
-            for (;;)
-            {
-                next = node->next.load();
-                if (next->remove_lock.compare_exchange_strong(_false, true))
-                {
-                    pred = node->pred.load();
-                    if (next == node->next.load()) break;
-                    next->remove_lock.store(false);
-                }
-                else
-                {
-                    _false = false;
-                }
-            }
-            for (;;)
-            {
-                next->pred.store(pred);
-                if (pred) pred->next.store(next);
-                auto _node = node;
-                if (!pred && !first.compare_exchange_strong(_node, next))
-                {
-                    while (node->pred.compare_exchange_strong(pred, pred)) {}
-                    continue;
-                }
-                break;
-            }
-            next->remove_lock.store(false);
-            node->remove_lock.store(false);
-            node->pred.store(nullptr);
-            node->next.store(nullptr);
-            return true;
+            return unlink(node) != unlink_result::contended;
         };
 
         /// <summary>
         /// Erase a previously emplaced node from the list.
         /// Using erase(), full concurrency safety for unique nodes.
-        /// Non-reentrant, non-concurrent with for_each(), and try_pop().
+        /// Non-reentrant, non-concurrent with for_each(), and try_pop(),
+        /// except with the lfllist_deferred_reclaim policy, where a node that
+        /// for_each() or try_pop() has already taken is left to these, and a node that is still
+        /// contended after unlink_attempts is marked erased and left to try_pop() or reclaim().
         /// Caveat: for_each() or try_pop() may erase any node pointer.
         /// </summary>
         /// <param name="to_erase">An item (not nullptr) that must be a member of this list.</param>
         auto erase(node_type* const to_erase) -> void
         {
-            while (!try_erase(to_erase)) {}
+            if constexpr (deferred_reclaim)
+            {
+                read_guard guard(*this);
+                // marked first, so that a competing try_pop() disposes of the node instead of returning it
+                to_erase->erased.store(true);
+                for (unsigned attempt = 0; attempt < unlink_attempts; ++attempt)
+                {
+                    if (try_erase(to_erase)) return;
+                }
+            }
+            else
+            {
+                while (!try_erase(to_erase)) {}
+            }
         }
 
         /// <summary>
         /// Try to erase a previously emplaced node from the list.
         /// Using try_erase(), full concurrency safety for unique nodes.
-        /// Non-reentrant, non-concurrent with for_each(), and try_pop().
+        /// Non-reentrant, non-concurrent with for_each(), and try_pop(),
+        /// except with the lfllist_deferred_reclaim policy, see erase().
         /// Caveat: for_each() or try_pop() may erase any node pointer.
         /// </summary>
         /// <param name="to_erase">An item (not nullptr) that must be a member of this list.</param>
         /// <returns>True on success, false if there is competition on locking to_erase.</returns>
         auto try_erase(node_type* const to_erase) -> bool
         {
-            if (!try_remove(to_erase)) return false;
-            destroy(to_erase);
+            const auto result = unlink(to_erase);
+            if (unlink_result::contended == result) return false;
+            if (unlink_result::removed == result) destroy(to_erase);
             return true;
         };
 
+        /// <summary>
+        /// Destroy a node that is not a member of the list, or with the lfllist_deferred_reclaim policy,
+        /// retire it for destruction by reclaim().
+        /// </summary>
+        /// <param name="node">A node pointer from a prior remove().</param>
         auto destroy(node_type* const node) -> void
         {
-            std::allocator_traits<Allocator>::destroy(alloc, node);
-            std::allocator_traits<Allocator>::deallocate(alloc, node, 1);
+            if constexpr (deferred_reclaim)
+            {
+                // next remains nullptr, which marks the node as removed to lagging readers
+                auto head = retired.load();
+                do
+                {
+                    node->pred.store(head);
+                } while (!retired.compare_exchange_weak(head, node));
+            }
+            else
+            {
+                dispose(node);
+            }
+        }
+
+        /// <summary>
+        /// With the lfllist_deferred_reclaim policy, unlink the nodes that erase() has left marked,
+        /// and destroy the retired nodes, unless any read_guard is active, in which case they remain
+        /// retired until the next call.
+        /// Non-reentrant, non-concurrent with reclaim().
+        /// </summary>
+        /// <returns>The number of nodes destroyed.</returns>
+        auto reclaim() -> std::size_t
+        {
+            if constexpr (!deferred_reclaim) return 0;
+            else
+            {
+                {
+                    read_guard guard(*this);
+                    // a node unlinked concurrently has no next, which ends the sweep until the next call
+                    for (auto node = first.load(); node && node != &last_sentinel;)
+                    {
+                        const auto next = node->next.load();
+                        if (node->erased.load()) try_erase(node);
+                        node = next;
+                    }
+                }
+                auto node = retired.exchange(nullptr);
+                if (!node) return 0;
+                // readers that start from here on cannot reach any node unlinked before the exchange
+                if (readers.load())
+                {
+                    auto tail = node;
+                    while (auto pred = tail->pred.load()) tail = pred;
+                    auto head = retired.load();
+                    do
+                    {
+                        tail->pred.store(head);
+                    } while (!retired.compare_exchange_weak(head, node));
+                    return 0;
+                }
+                std::size_t count = 0;
+                while (node)
+                {
+                    auto pred = node->pred.load();
+                    dispose(node);
+                    node = pred;
+                    ++count;
+                }
+                return count;
+            }
         }
 
         [[nodiscard]] auto back() -> node_type*
         {
-            if (auto node = last_sentinel.pred.load(); node) return node;
-            return nullptr;
+            auto node = last_sentinel.pred.load();
+            if constexpr (deferred_reclaim)
+            {
+                read_guard guard(*this);
+                while (node && node->erased.load()) node = node->pred.load();
+            }
+            return node;
         }
 
         /// <summary>
         /// Try to atomically get the item of and erase a node at the back of the list.
         /// Using try_pop(), full concurrency safety.
-        /// Non-reentrant, non-concurrent with erase().
+        /// Non-reentrant, non-concurrent with erase(), except with the lfllist_deferred_reclaim policy.
         /// </summary>
         /// <param name="item">An out argument that on success, receives the item at the back of this list.</param>
         /// <returns>True on success, false if the queue is empty or there is competition.</returns>
@@ -209,7 +321,7 @@ namespace ghostl
         /// <summary>
         /// Try to atomically remove a node at the back of the list.
         /// Using try_pop(), full concurrency safety.
-        /// Non-reentrant, non-concurrent with erase().
+        /// Non-reentrant, non-concurrent with erase(), except with the lfllist_deferred_reclaim policy.
         /// </summary>
         /// <param name="item">An out argument that on success, receives the item at the back of this list.</param>
         /// <returns>True on success, false if the queue is empty or there is competition.</returns>
@@ -217,11 +329,35 @@ namespace ghostl
         {
             auto _false = false;
             if (!pop_guard.compare_exchange_strong(_false, true)) { return false; }
+            read_guard guard(*this);
             auto has_node = false;
-            if (nullptr != (node = back()))
+            while (nullptr != (node = last_sentinel.pred.load()))
             {
-                remove(node);
-                has_node = true;
+                auto result = unlink_result::contended;
+                if constexpr (deferred_reclaim)
+                {
+                    for (unsigned attempt = 0; attempt < unlink_attempts &&
+                        unlink_result::contended == (result = unlink(node)); ++attempt) {}
+                    if (unlink_result::contended == result) break;
+                }
+                else
+                {
+                    while (unlink_result::contended == (result = unlink(node))) {}
+                }
+                // a concurrent erase() of the same node is only possible with deferred reclamation
+                if (unlink_result::removed == result)
+                {
+                    if constexpr (deferred_reclaim)
+                    {
+                        if (node->erased.load())
+                        {
+                            destroy(node);
+                            continue;
+                        }
+                    }
+                    has_node = true;
+                    break;
+                }
             }
             pop_guard.store(false);
             return has_node;
@@ -246,10 +382,67 @@ namespace ghostl
         };
 
     private:
+        enum class unlink_result { removed, contended, absent };
+
+        auto unlink(node_type* const node) -> unlink_result
+        {
+            auto _false = false;
+            if (!node->remove_lock.compare_exchange_strong(_false, true)) { return unlink_result::contended; }
+            if (!node->next.load())
+            {
+                // removed in the meantime by a competitor
+                node->remove_lock.store(false);
+                return unlink_result::absent;
+            }
+            node_type* next = nullptr;
+            node_type* pred = nullptr;
+            for (;;)
+            {
+                next = node->next.load();
+                if (next->remove_lock.compare_exchange_strong(_false, true))
+                {
+                    pred = node->pred.load();
+                    if (next == node->next.load()) break;
+                    next->remove_lock.store(false);
+                }
+                else
+                {
+                    _false = false;
+                }
+            }
+            for (;;)
+            {
+                next->pred.store(pred);
+                if (pred) pred->next.store(next);
+                auto _node = node;
+                if (!pred && !first.compare_exchange_strong(_node, next))
+                {
+                    while (node->pred.compare_exchange_strong(pred, pred)) {}
+                    continue;
+                }
+                break;
+            }
+            // competitors that take the lock next must find the node removed
+            node->pred.store(nullptr);
+            node->next.store(nullptr);
+            node->remove_lock.store(false);
+            next->remove_lock.store(false);
+            return unlink_result::removed;
+        };
+
+        auto dispose(node_type* const node) -> void
+        {
+            std::allocator_traits<Allocator>::destroy(alloc, node);
+            std::allocator_traits<Allocator>::deallocate(alloc, node, 1);
+        }
+
         Allocator alloc;
         node_type last_sentinel;
         std::atomic<node_type*> first = &last_sentinel;
         std::atomic<bool> pop_guard{ false };
+        // only in use with deferred reclamation
+        mutable std::atomic<unsigned> readers{ 0 };
+        std::atomic<node_type*> retired{ nullptr };
     };
 }
 
@@ -23,14 +23,61 @@
 
 #include "lfllist.h"
 
+#include <array>
+#include <new>
+
+#ifndef LFLLIST_ALLOCATOR_CORES
+#if defined(ESP32) && (portNUM_PROCESSORS > 1)
+#define LFLLIST_ALLOCATOR_CORES portNUM_PROCESSORS
+#else
+#define LFLLIST_ALLOCATOR_CORES 1
+#endif
+#endif
+
 namespace ghostl
 {
-    template<typename T, std::size_t CAPACITY>
-    struct lfllist_allocator : private lfllist<T>
+    namespace detail
+    {
+        inline auto lfllist_allocator_core() -> std::size_t
+        {
+#if LFLLIST_ALLOCATOR_CORES > 1
+            return xPortGetCoreID();
+#else
+            return 0;
+#endif
+        }
+
+        // in interrupt context, or with interrupts masked by a critical section
+        inline auto lfllist_allocator_in_isr() -> bool
+        {
+#if defined(ESP32)
+            return xPortInIsrContext();
+#elif defined(ESP8266)
+            uint32_t ps;
+            __asm__ __volatile__("rsr %0,ps" : "=a"(ps));
+            return ps & 0x0f;
+#else
+            return false;
+#endif
+        }
+    }
+
+    /// <summary>
+    /// Allocator of single objects from a free list of CAPACITY nodes in inline storage.
+    /// With MAX_SLABS, once the free list is exhausted, it grows by up to MAX_SLABS slabs of
+    /// CAPACITY nodes from the heap. This never happens in ISR context, where allocate()
+    /// then fails instead, so the inline nodes must suffice for the allocations from ISRs.
+    /// Allocation also fails if popping from the shared free list remains contended, as
+    /// happens to an ISR that preempts another allocation on the same core.
+    /// On multi-core MCUs, each core keeps a free list of up to 2 * MAGAZINE nodes of its own,
+    /// which exchanges nodes in batches of MAGAZINE with the shared free list.
+    /// </summary>
+    template<typename T, std::size_t CAPACITY, std::size_t MAX_SLABS = 0, std::size_t MAGAZINE = 8>
+    struct lfllist_allocator
     {
         // type definitions
-        using lfllist = lfllist<T>;
-        using node_type = lfllist::node_type;
+        using list_type = ghostl::lfllist<T>;
+        using node_type = typename list_type::node_type;
         using value_type = T;
         using pointer = T*;
         using const_pointer = const T*;
@@ -39,27 +86,33 @@ namespace ghostl
         using size_type = std::size_t;
         using difference_type = std::ptrdiff_t;
 
+        static constexpr size_type CORES = LFLLIST_ALLOCATOR_CORES;
+
+        template<typename U>
+        struct rebind
+        {
+            using other = lfllist_allocator<U, CAPACITY, MAX_SLABS, MAGAZINE>;
+        };
+
         lfllist_allocator()
         {
-            for (size_type i = 0; i < CAPACITY; ++i)
-            {
-                auto node = reinterpret_cast<node_type*>(&span[i * sizeof(node_type)]);
-                node = new (node) node_type();
-                lfllist::push(node);
-            }
+            add_nodes(span);
         }
         lfllist_allocator(const lfllist_allocator&) = delete;
         lfllist_allocator(lfllist_allocator&&) = delete;
         ~lfllist_allocator()
         {
-            node_type* node;
-            while (nullptr != (node = lfllist::back()))
+            // the nodes are not owned by the lists
+            for (auto& list : local) drain(list);
+            drain(shared);
+            for (auto& slab : slabs)
             {
-                lfllist::remove(node);
+                delete[] slab.load();
             }
         }
         auto operator =(const lfllist_allocator&)->lfllist_allocator & = delete;
         auto operator =(lfllist_allocator&&)->lfllist_allocator & = delete;
+
         [[nodiscard]] pointer allocate(size_type n, const void* = nullptr)
         {
             if (n != 1)
@@ -67,19 +120,136 @@ namespace ghostl
                 return nullptr;
             }
             node_type* node;
-            if (!lfllist::try_pop(node))
+            if constexpr (CORES > 1)
             {
-                return nullptr;
+                const auto core = detail::lfllist_allocator_core();
+                if (local[core].try_pop(node))
+                {
+                    --local_count[core];
+                    return reinterpret_cast<pointer>(node);
+                }
+                // refill the magazine in one go, and keep one node for this allocation
+                for (size_type i = 0; i < MAGAZINE && pop_shared(node); ++i)
+                {
+                    local[core].push(node);
+                    ++local_count[core];
+                }
+                if (local[core].try_pop(node))
+                {
+                    --local_count[core];
+                    return reinterpret_cast<pointer>(node);
+                }
+            }
+            if (pop_shared(node) || (grow() && pop_shared(node)))
+            {
+                return reinterpret_cast<pointer>(node);
             }
-            return reinterpret_cast<pointer>(node);
+            return nullptr;
         }
-        constexpr void deallocate(pointer const p, size_t n)
+        void deallocate(pointer const p, size_t)
         {
             auto node = reinterpret_cast<node_type*>(p);
-            lfllist::push(node);
+            if constexpr (CORES > 1)
+            {
+                const auto core = detail::lfllist_allocator_core();
+                local[core].push(node);
+                if (++local_count[core] > 2 * MAGAZINE)
+                {
+                    // return a batch to the other cores
+                    for (size_type i = 0; i < MAGAZINE && local[core].try_pop(node); ++i)
+                    {
+                        --local_count[core];
+                        shared.push(node);
+                    }
+                }
+                return;
+            }
+            shared.push(node);
+        }
+
+        /// <summary>
+        /// Check if an allocation is from the inline storage for CAPACITY nodes, as opposed to a slab.
+        /// </summary>
+        [[nodiscard]] bool is_inline(const void* const p) const
+        {
+            const auto node = static_cast<const char*>(p);
+            return node >= span && node < span + sizeof(span);
         }
+
     private:
-        char span[CAPACITY * sizeof(node_type)] = { 0 };
+        auto add_nodes(char* const nodes) -> void
+        {
+            for (size_type i = 0; i < CAPACITY; ++i)
+            {
+                auto node = reinterpret_cast<node_type*>(&nodes[i * sizeof(node_type)]);
+                node = new (node) node_type();
+                shared.push(node);
+            }
+        }
+
+        auto pop_shared(node_type*& node) -> bool
+        {
+            // try_pop only fails spuriously on competition, retry a few times unless empty,
+            // a preempted competitor on the same core never completes during the retries
+            for (unsigned attempt = 0; attempt < POP_ATTEMPTS && shared.back(); ++attempt)
+            {
+                if (shared.try_pop(node)) return true;
+            }
+            return false;
+        }
+
+        auto grow() -> bool
+        {
+            if constexpr (MAX_SLABS > 0)
+            {
+                // the heap is not available to ISRs
+                if (detail::lfllist_allocator_in_isr()) return false;
+                auto slab_index = slab_count.load();
+                do
+                {
+                    if (slab_index >= MAX_SLABS) return false;
+                } while (!slab_count.compare_exchange_weak(slab_index, slab_index + 1));
+                auto slab = new (std::nothrow) node_storage[CAPACITY];
+                if (!slab)
+                {
+                    // another attempt may succeed later
+                    --slab_count;
+                    return false;
+                }
+                // the slab count guarantees a free slot
+                for (auto& _slab : slabs)
+                {
+                    node_storage* _null = nullptr;
+                    if (_slab.compare_exchange_strong(_null, slab)) break;
+                }
+                add_nodes(reinterpret_cast<char*>(slab));
+                return true;
+            }
+            return false;
+        }
+
+        static auto drain(list_type& list) -> void
+        {
+            node_type* node;
+            while (nullptr != (node = list.back()))
+            {
+                list.remove(node);
+            }
+        }
+
+        static constexpr unsigned POP_ATTEMPTS = 8;
+
+        struct node_storage
+        {
+            alignas(node_type) char bytes[sizeof(node_type)];
+        };
+
+        list_type shared;
+        std::array<list_type, (CORES > 1) ? CORES : 0> local;
+        std::array<std::atomic<size_type>, (CORES > 1) ? CORES : 0> local_count{};
+        std::array<std::atomic<node_storage*>, MAX_SLABS> slabs{};
+        std::atomic<size_type> slab_count{ 0 };
+        alignas(node_type) char span[CAPACITY * sizeof(node_type)] = { 0 };
     };
 }
 
@@ -29,7 +29,7 @@ namespace ghostl
     {
         struct final_task final
         {
-            struct promise_type final
+            struct promise_type final : frame_allocated
             {
                 final_task get_return_object() noexcept
                 {
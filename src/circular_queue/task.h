@@ -21,13 +21,14 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <atomic>
 #include <memory>
 #include <coroutine>
+#include "frame_allocator.h"
 
 namespace ghostl
 {
     template<class T = void>
     struct task
     {
-        struct promise_type final
+        struct promise_type final : frame_allocated
         {
             auto get_return_object() noexcept
             {
@@ -110,7 +111,7 @@ namespace ghostl
     template<>
     struct task<void>
     {
-        struct promise_type final
+        struct promise_type final : frame_allocated
         {
             auto get_return_object() noexcept
             {
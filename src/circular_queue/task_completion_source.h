@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <atomic>
 #include <memory>
 #include <coroutine>
+#include <utility>
 
 #if defined(__GNUC__)
 #undef ALWAYS_INLINE_ATTR